@@ -0,0 +1,63 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+/**
+ * @file bench_common.h
+ * @brief Signal sources, work directory and configuration shared by the benchmarks
+ *
+ * Each benchmark program is a single translation unit, so the helpers are
+ * defined here as static functions.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "cts_monitor.h"
+
+/** CTS toggles on every sample of the 1 us virtual clock */
+#define BENCH_EDGE_DEVICE "synthetic:step=1us,CTS=500k"
+
+/** All signals constant: samples without edges */
+#define BENCH_IDLE_DEVICE "synthetic:step=1us"
+
+/** Temporary directory for output files, created by the program's main() */
+static char work_dir[64];
+
+/**
+ * @brief Remove everything a run wrote to the work directory
+ */
+static void clear_work_dir(void) {
+    DIR *dir = opendir(work_dir);
+    struct dirent *entry;
+    char path[sizeof(work_dir) + 256];
+
+    if (!dir) {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            snprintf(path, sizeof(path), "%s/%s", work_dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Polling text output to /dev/null, the starting point of every benchmark
+ * @param config Configuration to fill
+ * @param device Signal source
+ */
+static void base_config(monitor_config_t *config, const char *device) {
+    memset(config, 0, sizeof(*config));
+    config->serial_device = device;
+    config->poll_interval_us = 1000;
+    config->mode = MONITOR_MODE_POLLING;
+    config->output_backend = OUTPUT_BACKEND_STDIO;
+    config->output_format = OUTPUT_FORMAT_TEXT;
+    config->output_file = "/dev/null";
+    config->replay_speed = 1.0;
+}
+
+#endif /* BENCH_COMMON_H */
@@ -0,0 +1,177 @@
+// End-to-end throughput benchmark
+//
+// Drives the monitor through its public API with the synthetic backend on a
+// virtual sample clock, so every run sees exactly the same signal sequence:
+//   pipeline.*  edges/s from sampling to the written record, per output
+//               format, time format and output destination
+//   loop.*      per-sample cost of each monitor mode's loop body, no edges
+//   timestamp.* cost of formatting one record timestamp
+// Results are printed as a fixed-order table for tracking across releases.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "cts_monitor.h"
+#include "timestamp.h"
+#include "bench_common.h"
+
+// Default samples per run
+#define BENCH_DEFAULT_SAMPLES 1000000L
+
+typedef enum {
+    DEST_NULL,      /**< stdio stream to /dev/null (formatting only) */
+    DEST_FILE,      /**< stdio stream to a file */
+    DEST_ROTATE,    /**< Size-rotated files */
+    DEST_MMAP       /**< Memory-mapped segments */
+} bench_dest_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_result(const char *name, long ops, double seconds) {
+    printf("%-32s %10ld %10.1f %12.0f\n", name, ops, seconds * 1e9 / ops, ops / seconds);
+    fflush(stdout);
+}
+
+// Edges per second from sampling to the written record
+static int bench_pipeline(const char *name, output_format_t format, time_format_t time_format,
+                          bench_dest_t dest, long samples) {
+    monitor_config_t config;
+    char output[sizeof(work_dir) + 16];
+
+    snprintf(output, sizeof(output), "%s/capture", work_dir);
+    base_config(&config, BENCH_EDGE_DEVICE);
+    config.output_format = format;
+    config.time_format = time_format;
+    config.output_file = dest == DEST_NULL ? "/dev/null" : output;
+    if (dest == DEST_ROTATE) {
+        config.rotate_size = 16ULL * 1024 * 1024;
+    } else if (dest == DEST_MMAP) {
+        config.output_backend = OUTPUT_BACKEND_MMAP;
+    }
+
+    cts_monitor_t *monitor = cts_monitor_create(&config);
+    if (!monitor) {
+        fprintf(stderr, "%s: monitor initialization failed\n", name);
+        return -1;
+    }
+
+    double start = now_seconds();
+    for (long i = 0; i < samples; i++) {
+        if (cts_monitor_update(monitor) != 0) {
+            fprintf(stderr, "%s: update failed\n", name);
+            cts_monitor_destroy(monitor);
+            return -1;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    cts_monitor_destroy(monitor);
+    clear_work_dir();
+    print_result(name, samples, elapsed);
+    return 0;
+}
+
+// Cost of one pass through a monitor mode's loop body without edges
+static int bench_loop(const char *name, monitor_mode_t mode, long samples) {
+    monitor_config_t config;
+
+    base_config(&config, BENCH_IDLE_DEVICE);
+    config.mode = mode;
+
+    cts_monitor_t *monitor = cts_monitor_create(&config);
+    if (!monitor || (mode == MONITOR_MODE_IRQ && cts_monitor_start_irq(monitor) != 0)) {
+        fprintf(stderr, "%s: monitor initialization failed\n", name);
+        cts_monitor_destroy(monitor);
+        return -1;
+    }
+
+    double start = now_seconds();
+    for (long i = 0; i < samples; i++) {
+        int ret = mode == MONITOR_MODE_IRQ ? cts_monitor_process_irq_events(monitor) :
+                                             cts_monitor_update(monitor);
+        if (ret < 0) {
+            fprintf(stderr, "%s: sample failed\n", name);
+            cts_monitor_destroy(monitor);
+            return -1;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    cts_monitor_destroy(monitor);
+    print_result(name, samples, elapsed);
+    return 0;
+}
+
+static void bench_timestamp(const char *name, time_format_t format, long samples) {
+    struct timespec start_time, ts;
+    char buffer[64];
+    volatile char sink = 0;
+
+    clock_gettime(CLOCK_REALTIME, &start_time);
+    ts = start_time;
+
+    double start = now_seconds();
+    for (long i = 0; i < samples; i++) {
+        // Advance like a 1 us sample clock so nothing can be cached
+        ts.tv_nsec += 1000;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        timestamp_format(&ts, &start_time, format, buffer, sizeof(buffer));
+        sink ^= buffer[0];
+    }
+    double elapsed = now_seconds() - start;
+
+    (void)sink;
+    print_result(name, samples, elapsed);
+}
+
+int main(int argc, char *argv[]) {
+    long samples = BENCH_DEFAULT_SAMPLES;
+    int failed = 0;
+
+    if (argc > 1) {
+        samples = atol(argv[1]);
+        if (samples <= 0) {
+            fprintf(stderr, "Usage: %s [samples per run]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    snprintf(work_dir, sizeof(work_dir), "/tmp/cts_bench.XXXXXX");
+    if (!mkdtemp(work_dir)) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+
+    printf("CTS Monitor throughput benchmark, %ld samples per run\n\n", samples);
+    printf("%-32s %10s %10s %12s\n", "BENCHMARK", "OPS", "NS/OP", "OPS/S");
+
+    failed |= bench_pipeline("pipeline.text.abs.null", OUTPUT_FORMAT_TEXT, TIME_FORMAT_ABSOLUTE, DEST_NULL, samples);
+    failed |= bench_pipeline("pipeline.text.abs.file", OUTPUT_FORMAT_TEXT, TIME_FORMAT_ABSOLUTE, DEST_FILE, samples);
+    failed |= bench_pipeline("pipeline.text.abs.rotate", OUTPUT_FORMAT_TEXT, TIME_FORMAT_ABSOLUTE, DEST_ROTATE, samples);
+    failed |= bench_pipeline("pipeline.text.abs.mmap", OUTPUT_FORMAT_TEXT, TIME_FORMAT_ABSOLUTE, DEST_MMAP, samples);
+    failed |= bench_pipeline("pipeline.text.rel.null", OUTPUT_FORMAT_TEXT, TIME_FORMAT_RELATIVE, DEST_NULL, samples);
+    failed |= bench_pipeline("pipeline.text.rel.file", OUTPUT_FORMAT_TEXT, TIME_FORMAT_RELATIVE, DEST_FILE, samples);
+    failed |= bench_pipeline("pipeline.text.rel.rotate", OUTPUT_FORMAT_TEXT, TIME_FORMAT_RELATIVE, DEST_ROTATE, samples);
+    failed |= bench_pipeline("pipeline.text.rel.mmap", OUTPUT_FORMAT_TEXT, TIME_FORMAT_RELATIVE, DEST_MMAP, samples);
+    failed |= bench_pipeline("pipeline.vcd.file", OUTPUT_FORMAT_VCD, TIME_FORMAT_ABSOLUTE, DEST_FILE, samples);
+    failed |= bench_pipeline("pipeline.pcapng.file", OUTPUT_FORMAT_PCAPNG, TIME_FORMAT_ABSOLUTE, DEST_FILE, samples);
+
+    failed |= bench_loop("loop.poll", MONITOR_MODE_POLLING, samples);
+    failed |= bench_loop("loop.irq", MONITOR_MODE_IRQ, samples);
+
+    bench_timestamp("timestamp.abs", TIME_FORMAT_ABSOLUTE, samples);
+    bench_timestamp("timestamp.rel", TIME_FORMAT_RELATIVE, samples);
+
+    clear_work_dir();
+    rmdir(work_dir);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+// Microbenchmarks of the per-sample path
+//
+// Each function a sample passes through is timed on its own, so a
+// regression shows up in the step that caused it rather than as a smaller
+// drift of the end-to-end numbers:
+//   decode.*     TIOCMGET bit decoding of the serial port backend
+//   read.*       backend read_state() of the synthetic generator
+//   diff.*       edge diffing of two samples, without and with a change
+//   timestamp.*  record timestamp formatting in both time formats
+//   update.*     one cts_monitor_update() without and with an edge
+//   log.*        log_signal_change(), derived as update.edge - update.idle
+// The process is pinned to one CPU and every benchmark runs a warm-up pass
+// before its timed repetitions; min, median and max ns/op are reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include "cts_monitor.h"
+#include "capture_backend.h"
+#include "signal_state.h"
+#include "timestamp.h"
+#include "bench_common.h"
+
+// Defaults: operations per repetition, repetitions
+#define MICRO_DEFAULT_OPS 200000L
+#define MICRO_DEFAULT_REPS 7
+#define MICRO_MAX_REPS 100
+
+// Runs n operations of one benchmark
+typedef int (*micro_fn_t)(void *arg, long n);
+
+// Per-repetition ns/op summary
+typedef struct {
+    double min;
+    double median;
+    double max;
+} micro_result_t;
+
+static long ops = MICRO_DEFAULT_OPS;
+static int reps = MICRO_DEFAULT_REPS;
+
+// Results are folded into this so the compiler cannot drop the work
+static volatile int sink;
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help     Show this help message\n");
+    printf("  -n OPS         Operations per repetition (default: %ld)\n", MICRO_DEFAULT_OPS);
+    printf("  -r REPS        Timed repetitions, 1-%d (default: %d)\n", MICRO_MAX_REPS, MICRO_DEFAULT_REPS);
+    printf("  -c CPU         Pin to CPU (default: the CPU the benchmark starts on)\n");
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int pin_cpu(int cpu) {
+    cpu_set_t set;
+
+    if (cpu < 0) {
+        cpu = sched_getcpu();
+        if (cpu < 0) {
+            perror("sched_getcpu");
+            return -1;
+        }
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+        fprintf(stderr, "Error pinning to CPU %d: ", cpu);
+        perror(NULL);
+        return -1;
+    }
+    return cpu;
+}
+
+// Warm up with a tenth of a repetition, then time each repetition
+static int measure(micro_fn_t fn, void *arg, micro_result_t *result) {
+    double per_op[MICRO_MAX_REPS];
+
+    if (fn(arg, ops / 10 + 1) < 0) {
+        return -1;
+    }
+    for (int r = 0; r < reps; r++) {
+        double start = now_ns();
+        if (fn(arg, ops) < 0) {
+            return -1;
+        }
+        per_op[r] = (now_ns() - start) / ops;
+    }
+
+    qsort(per_op, reps, sizeof(per_op[0]), compare_double);
+    result->min = per_op[0];
+    result->median = per_op[reps / 2];
+    result->max = per_op[reps - 1];
+    return 0;
+}
+
+static void print_result(const char *name, const micro_result_t *result) {
+    printf("%-28s %10.1f %10.1f %10.1f\n", name, result->min, result->median, result->max);
+    fflush(stdout);
+}
+
+static int run(const char *name, micro_fn_t fn, void *arg, micro_result_t *result) {
+    micro_result_t local;
+
+    if (!result) {
+        result = &local;
+    }
+    if (measure(fn, arg, result) < 0) {
+        fprintf(stderr, "%s: benchmark failed\n", name);
+        return -1;
+    }
+    print_result(name, result);
+    return 0;
+}
+
+static int bench_decode(void *arg, long n) {
+    // Every combination of the four modem lines plus unrelated bits
+    static const int status[4] = {
+        0,
+        TIOCM_CTS | TIOCM_DSR,
+        TIOCM_RTS | TIOCM_DTR | TIOCM_CAR,
+        TIOCM_CTS | TIOCM_RTS | TIOCM_DSR | TIOCM_DTR | TIOCM_RNG
+    };
+    signal_state_t state;
+
+    (void)arg;
+    for (long i = 0; i < n; i++) {
+        signal_state_decode(status[i & 3], &state);
+        sink += state.cts + state.rts + state.dsr + state.dtr;
+    }
+    return 0;
+}
+
+static int bench_read(void *arg, long n) {
+    capture_backend_t *backend = arg;
+    signal_state_t state;
+    struct timespec ts;
+
+    for (long i = 0; i < n; i++) {
+        if (backend->ops->read_state(backend, &state, &ts) != 0) {
+            return -1;
+        }
+        sink += state.cts;
+    }
+    return 0;
+}
+
+static int bench_diff_idle(void *arg, long n) {
+    signal_state_t a = { 1, 1, 0, 0 };
+    signal_state_t b = a;
+    int mask = *(const int *)arg;
+
+    for (long i = 0; i < n; i++) {
+        sink += signal_state_changes(&a, &b, mask);
+    }
+    return 0;
+}
+
+static int bench_diff_edge(void *arg, long n) {
+    signal_state_t states[2] = { { 1, 1, 0, 0 }, { 0, 1, 0, 0 } };
+    int mask = *(const int *)arg;
+
+    for (long i = 0; i < n; i++) {
+        sink += signal_state_changes(&states[i & 1], &states[~i & 1], mask);
+    }
+    return 0;
+}
+
+static int bench_timestamp(void *arg, long n) {
+    time_format_t format = *(const time_format_t *)arg;
+    static struct timespec start_time, ts;
+    char buffer[64];
+
+    if (start_time.tv_sec == 0) {
+        clock_gettime(CLOCK_REALTIME, &start_time);
+        ts = start_time;
+    }
+    for (long i = 0; i < n; i++) {
+        // Advance like a 1 us sample clock so nothing can be cached
+        ts.tv_nsec += 1000;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        timestamp_format(&ts, &start_time, format, buffer, sizeof(buffer));
+        sink += buffer[0];
+    }
+    return 0;
+}
+
+static int bench_update(void *arg, long n) {
+    cts_monitor_t *monitor = arg;
+    for (long i = 0; i < n; i++) {
+        if (cts_monitor_update(monitor) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int run_read(void) {
+    monitor_config_t config;
+    capture_backend_t backend;
+
+    base_config(&config, BENCH_EDGE_DEVICE);
+    if (capture_backend_open(&backend, &config) < 0) {
+        return -1;
+    }
+    int result = run("read.synthetic", bench_read, &backend, NULL);
+    capture_backend_close(&backend);
+    return result;
+}
+
+// One monitor instance per configuration
+static int run_update(const char *name, const char *device, output_backend_t output,
+                      micro_result_t *result) {
+    monitor_config_t config;
+    char output_file[sizeof(work_dir) + 16];
+
+    base_config(&config, device);
+    config.time_format = TIME_FORMAT_RELATIVE;
+    if (output == OUTPUT_BACKEND_MMAP) {
+        snprintf(output_file, sizeof(output_file), "%s/capture", work_dir);
+        config.output_backend = OUTPUT_BACKEND_MMAP;
+        config.output_file = output_file;
+    }
+    cts_monitor_t *monitor = cts_monitor_create(&config);
+    if (!monitor) {
+        fprintf(stderr, "%s: monitor initialization failed\n", name);
+        return -1;
+    }
+    int failed = run(name, bench_update, monitor, result);
+    cts_monitor_destroy(monitor);
+    clear_work_dir();
+    return failed;
+}
+
+// Edge cost on top of an idle sample
+static void print_derived(const char *name, const micro_result_t *edge, const micro_result_t *idle) {
+    micro_result_t diff = {
+        edge->min - idle->min,
+        edge->median - idle->median,
+        edge->max - idle->max
+    };
+    print_result(name, &diff);
+}
+
+int main(int argc, char *argv[]) {
+    int cpu = -1;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            ops = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cpu = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (ops <= 0 || reps < 1 || reps > MICRO_MAX_REPS) {
+        fprintf(stderr, "Error: Invalid operation or repetition count\n");
+        return EXIT_FAILURE;
+    }
+
+    cpu = pin_cpu(cpu);
+    if (cpu < 0) {
+        return EXIT_FAILURE;
+    }
+
+    snprintf(work_dir, sizeof(work_dir), "/tmp/cts_microbench.XXXXXX");
+    if (!mkdtemp(work_dir)) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+
+    printf("CTS Monitor microbenchmarks, CPU %d, %ld ops x %d repetitions\n\n", cpu, ops, reps);
+    printf("%-28s %10s %10s %10s\n", "BENCHMARK", "MIN NS/OP", "MEDIAN", "MAX");
+
+    int default_mask = (1 << SIGNAL_CTS) | (1 << SIGNAL_RTS);
+    int verbose_mask = default_mask | (1 << SIGNAL_DSR) | (1 << SIGNAL_DTR);
+    time_format_t absolute = TIME_FORMAT_ABSOLUTE;
+    time_format_t relative = TIME_FORMAT_RELATIVE;
+    micro_result_t idle, edge_null, edge_mmap;
+
+    failed |= run("decode.modem", bench_decode, NULL, NULL);
+    failed |= run_read();
+    failed |= run("diff.idle", bench_diff_idle, &default_mask, NULL);
+    failed |= run("diff.edge", bench_diff_edge, &default_mask, NULL);
+    failed |= run("diff.edge.verbose", bench_diff_edge, &verbose_mask, NULL);
+    failed |= run("timestamp.abs", bench_timestamp, &absolute, NULL);
+    failed |= run("timestamp.rel", bench_timestamp, &relative, NULL);
+
+    failed |= run_update("update.idle", BENCH_IDLE_DEVICE, OUTPUT_BACKEND_STDIO, &idle);
+    failed |= run_update("update.edge.null", BENCH_EDGE_DEVICE, OUTPUT_BACKEND_STDIO, &edge_null);
+    failed |= run_update("update.edge.mmap", BENCH_EDGE_DEVICE, OUTPUT_BACKEND_MMAP, &edge_mmap);
+    if (!failed) {
+        print_derived("log.text.rel.null", &edge_null, &idle);
+        print_derived("log.text.rel.mmap", &edge_mmap, &idle);
+    }
+
+    clear_work_dir();
+    rmdir(work_dir);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
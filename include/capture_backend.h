@@ -0,0 +1,147 @@
+#ifndef CAPTURE_BACKEND_H
+#define CAPTURE_BACKEND_H
+
+/**
+ * @file capture_backend.h
+ * @brief Pluggable signal capture backends
+ *
+ * A backend turns a device string into signal samples. The monitor only
+ * talks to the operations table, so serial ports, FTDI chips and the
+ * synthetic generator all feed the same edge pipeline.
+ *
+ * Device strings:
+ *   /dev/ttyXXX          serial port via TIOCMGET (FTDI GPIO when available)
+ *   synthetic[:SPEC]     generated signals, see synthetic_backend_ops
+ *   replay:FILE          edges of a text log, see replay_backend_ops
+ */
+
+#include <time.h>
+#include "cts_monitor.h"
+
+typedef struct capture_backend capture_backend_t;
+
+/**
+ * @brief Backend operations
+ */
+typedef struct {
+    const char *name;   /**< Backend name for messages */
+
+    /**
+     * @brief Open the device
+     * @param backend Backend instance (ops and verbose are set)
+     * @param config Monitor configuration; serial_device is the device string
+     * @return 0 on success, -1 on failure
+     */
+    int (*open)(capture_backend_t *backend, const monitor_config_t *config);
+
+    /**
+     * @brief Sample all signals
+     * @param backend Backend instance
+     * @param state Receives the signal levels
+     * @param ts Receives the sample time
+     * @return 0 on success, 1 at the end of the input (state not updated), -1 on failure
+     */
+    int (*read_state)(capture_backend_t *backend, signal_state_t *state, struct timespec *ts);
+
+    /**
+     * @brief Wait until a signal may have changed
+     * @param backend Backend instance
+     * @param timeout_ms Longest time to wait
+     * @return 1 on activity, 0 on timeout or interruption, -1 on failure
+     */
+    int (*wait_edge)(capture_backend_t *backend, int timeout_ms);
+
+    /**
+     * @brief Drive output lines (NULL if the backend cannot)
+     * @param backend Backend instance
+     * @param set_mask Lines to raise, bit per signal_id_t (RTS and DTR)
+     * @param clear_mask Lines to lower, bit per signal_id_t (RTS and DTR)
+     * @param ts Receives the time the write completed, on the read_state() clock
+     * @return 0 on success, -1 on failure
+     */
+    int (*set_lines)(capture_backend_t *backend, int set_mask, int clear_mask, struct timespec *ts);
+
+    /**
+     * @brief Close the device and free the backend state
+     * @param backend Backend instance
+     */
+    void (*close)(capture_backend_t *backend);
+} capture_backend_ops_t;
+
+/**
+ * @brief Open capture backend
+ */
+struct capture_backend {
+    const capture_backend_ops_t *ops;   /**< Operations of the selected backend */
+    int verbose;                        /**< Print progress messages */
+    void *priv;                         /**< Backend-specific state */
+};
+
+/** Serial port backend reading modem lines with TIOCMGET, driving RTS/DTR with TIOCMBIS/TIOCMBIC */
+extern const capture_backend_ops_t tty_backend_ops;
+
+#ifdef HAVE_LIBFTDI1
+/** FTDI backend reading GPIO pins in bitbang mode */
+extern const capture_backend_ops_t ftdi_backend_ops;
+
+/**
+ * @brief Detect if device is an FTDI device
+ * @param device_path Path to the serial device
+ * @return 1 if FTDI device, 0 if not, -1 on error
+ */
+int ftdi_backend_probe(const char *device_path);
+#endif
+
+/**
+ * @brief Synthetic signal generator
+ *
+ * SPEC is a ','-separated list of SIG=PATTERN; signals not listed stay LOW.
+ *   SIG=0 | SIG=1            constant level
+ *   SIG=FREQ[/DUTY]          square wave, FREQ in Hz with optional k or M
+ *                            suffix, DUTY in percent HIGH (default 50)
+ *   SIG=OTHER+DELAY          copy of OTHER delayed by DELAY (ns, us, ms or
+ *                            s suffix, default us); OTHER must not be a copy
+ *   step=DELAY               sample on a virtual clock advancing DELAY per
+ *                            sample instead of the real clock, for
+ *                            reproducible runs and benchmarks
+ * Driving RTS or DTR through set_lines() replaces its pattern with the
+ * driven level, so "CTS=RTS+50us" acts as a loopback plug with 50 us delay
+ * (delays must stay below the time between writes to one line).
+ * Without a SPEC, "RTS=1k,CTS=RTS+100us" is generated. Levels are derived
+ * from the clock, so rates well above the sampling rate alias just like a
+ * real line would.
+ */
+extern const capture_backend_ops_t synthetic_backend_ops;
+
+/**
+ * @brief Replay of a cts_monitor text log
+ *
+ * Each sample applies the edges of the next log timestamp, so every logged
+ * edge reaches the edge path with its original time (relative logs are
+ * replayed relative to the replay start). With config->replay_speed > 0,
+ * samples are paced at that multiple of the original timing; with 0 they
+ * follow each other as fast as possible. Initial levels are taken as the
+ * opposite of each signal's first edge.
+ */
+extern const capture_backend_ops_t replay_backend_ops;
+
+/**
+ * @brief Select and open the backend for a device string
+ *
+ * "synthetic..." selects the generator and "replay:" the log replay; FTDI
+ * devices use the FTDI backend when built with libftdi1 and fall back to
+ * the serial port backend.
+ *
+ * @param backend Backend instance to initialize
+ * @param config Monitor configuration; serial_device is the device string
+ * @return 0 on success, -1 on failure
+ */
+int capture_backend_open(capture_backend_t *backend, const monitor_config_t *config);
+
+/**
+ * @brief Close an open backend
+ * @param backend Backend instance
+ */
+void capture_backend_close(capture_backend_t *backend);
+
+#endif /* CAPTURE_BACKEND_H */
@@ -0,0 +1,74 @@
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+/**
+ * @file control_server.h
+ * @brief Line-based control socket for runtime reconfiguration
+ *
+ * Clients connect to a Unix socket and send one command per line; every
+ * line is answered with one line. The server is serviced without blocking
+ * from the capture loop, so commands are handled between two samples.
+ */
+
+#include <stddef.h>
+#include <time.h>
+
+/** Maximum number of concurrent control connections */
+#define CONTROL_SERVER_MAX_CLIENTS 4
+
+/** Maximum length of a command or reply line */
+#define CONTROL_SERVER_LINE_MAX 512
+
+/**
+ * @brief Command handler
+ * @param context Handler context given to control_server_service()
+ * @param command Command line without the line terminator (may be modified)
+ * @param reply Receives the reply line without a terminator
+ * @param reply_size Size of reply
+ */
+typedef void (*control_handler_t)(void *context, char *command, char *reply, size_t reply_size);
+
+/**
+ * @brief Control connection
+ */
+typedef struct {
+    int fd;                             /**< Client socket, -1 if unused */
+    char line[CONTROL_SERVER_LINE_MAX]; /**< Bytes of the incomplete command line */
+    size_t line_len;                    /**< Bytes in line */
+    struct timespec active;             /**< Time of the last command or the connect */
+} control_client_t;
+
+/**
+ * @brief Control server state
+ */
+typedef struct {
+    const char *path;       /**< Socket path */
+    int listen_fd;          /**< Listening socket */
+    control_client_t clients[CONTROL_SERVER_MAX_CLIENTS]; /**< Connections */
+} control_server_t;
+
+/**
+ * @brief Start listening for control connections
+ * @param server Server state to initialize
+ * @param path Unix socket path
+ * @return 0 on success, -1 on failure
+ */
+int control_server_open(control_server_t *server, const char *path);
+
+/**
+ * @brief Accept connections and run complete commands without blocking
+ * @param server Server state
+ * @param handler Called for every non-empty command line
+ * @param context Passed to handler
+ * @param now Current time
+ */
+void control_server_service(control_server_t *server, control_handler_t handler, void *context,
+                            const struct timespec *now);
+
+/**
+ * @brief Close all connections and remove the socket
+ * @param server Server state
+ */
+void control_server_close(control_server_t *server);
+
+#endif /* CONTROL_SERVER_H */
@@ -10,10 +10,16 @@
  * high precision timing.
  */
 
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
-#ifdef HAVE_LIBFTDI1
-#include <ftdi.h>
+/** Marks the public API; everything else stays internal to libctsmonitor.so */
+#if defined(__GNUC__)
+#define CTS_MONITOR_API __attribute__((visibility("default")))
+#else
+#define CTS_MONITOR_API
 #endif
 
 /**
@@ -32,6 +38,17 @@ typedef enum {
     TIME_FORMAT_RELATIVE    /**< Relative timestamp from start (seconds.microseconds) */
 } time_format_t;
 
+/**
+ * @brief Monitored signal identifiers
+ */
+typedef enum {
+    SIGNAL_CTS,             /**< Clear To Send */
+    SIGNAL_RTS,             /**< Request To Send */
+    SIGNAL_DSR,             /**< Data Set Ready */
+    SIGNAL_DTR,             /**< Data Terminal Ready */
+    SIGNAL_COUNT            /**< Number of monitored signals */
+} signal_id_t;
+
 /**
  * @brief Signal state structure
  */
@@ -50,6 +67,24 @@ typedef enum {
     MONITOR_MODE_IRQ        /**< Event-driven monitoring using select() system call */
 } monitor_mode_t;
 
+/**
+ * @brief Output backend options
+ */
+typedef enum {
+    OUTPUT_BACKEND_STDIO,   /**< Buffered stdio stream (default) */
+    OUTPUT_BACKEND_MMAP,    /**< Memory-mapped rolling capture segments */
+    OUTPUT_BACKEND_NONE     /**< No records; edges only reach callbacks, subscribers and analyzers */
+} output_backend_t;
+
+/**
+ * @brief Output record formats
+ */
+typedef enum {
+    OUTPUT_FORMAT_TEXT,     /**< Timestamped text lines (default) */
+    OUTPUT_FORMAT_VCD,      /**< Value Change Dump for waveform viewers */
+    OUTPUT_FORMAT_PCAPNG    /**< PCAP-NG with one packet per edge */
+} output_format_t;
+
 /**
  * @brief Monitor configuration structure
  */
@@ -61,75 +96,215 @@ typedef struct {
     int verbose;                   /**< Verbose mode flag */
     monitor_mode_t mode;           /**< Monitoring mode: polling or IRQ-driven */
     device_type_t device_type;     /**< Device type: standard or FTDI */
+    output_backend_t output_backend; /**< Output backend: stdio or mmap */
+    output_format_t output_format; /**< Output record format: text, VCD or PCAP-NG */
+    size_t segment_size;           /**< Capture segment size in bytes (mmap backend, 0 for default) */
+    unsigned long long rotate_size; /**< Rotate output file after this many bytes (0 = never) */
+    long rotate_interval;          /**< Rotate output on wall-clock periods of this many seconds (0 = never) */
+    int stats;                     /**< Collect pulse-width and period statistics */
+    const char *hist_file;         /**< Write pulse-width/RTS->CTS histograms here at exit (NULL = off) */
+    int handshake;                 /**< Analyze RTS->CTS handshakes and report per minute */
+    long handshake_timeout_us;     /**< Flag handshakes not answered within this many microseconds */
+    int latency;                   /**< Measure detection window and write latency per edge */
+    long min_pulse_us[SIGNAL_COUNT]; /**< Drop pulses shorter than this per signal in microseconds (0 = off) */
+    const char *trigger;           /**< Trigger expression; only edges around a trigger are written (NULL = off) */
+    size_t pre_trigger_edges;      /**< Edges kept before the trigger (0 for default) */
+    long long post_trigger_ns;     /**< Time edges keep being written after the trigger */
+    const char *stream_socket;     /**< Unix socket path for live subscribers (NULL = off) */
+    size_t stream_queue_size;      /**< Per-subscriber queue size in bytes (0 for default) */
+    const char *shm_name;          /**< POSIX shared-memory edge ring name (NULL = off) */
+    size_t shm_slots;              /**< Edge ring slots (0 for default) */
+    double replay_speed;           /**< Replay timing multiple for replay: devices (0 = as fast as possible) */
+    const char *metrics_endpoint;  /**< Prometheus endpoint: TCP port on 127.0.0.1 or unix:PATH (NULL = off) */
+    const char *loopback;          /**< Loopback test pattern driving RTS/DTR (NULL = off) */
+    double loopback_rate;          /**< Loopback pattern steps per second */
+    unsigned long long loopback_count; /**< Loopback steps to drive (0 = until stopped) */
+    int output_thread;             /**< Format and write records on a separate normal-priority thread */
+    int signal_mask;               /**< Signals producing edges, bit per signal_id_t (0 = CTS/RTS, all if verbose) */
+    const char *control_socket;    /**< Unix socket for runtime reconfiguration (NULL = off) */
 } monitor_config_t;
 
+/** Shortest accepted polling interval in microseconds */
+#define CTS_MONITOR_MIN_POLL_INTERVAL_US 100
+
 /**
- * @brief Initialize the CTS monitor
- * @param config Pointer to configuration structure
- * @return 0 on success, -1 on failure
+ * @brief Settings that can be changed while capturing
+ */
+typedef struct {
+    int poll_interval_us;          /**< Polling interval in microseconds (polling mode only) */
+    int signal_mask;               /**< Signals producing edges, bit per signal_id_t */
+    const char *output_file;       /**< Output file path (NULL for stdout) */
+} cts_monitor_settings_t;
+
+/**
+ * @brief Monitor instance
+ *
+ * Holds the complete state of one monitored port, including all sample
+ * and edge buffers, so nothing is allocated on the sample path. Separate
+ * instances share no state and may run in parallel threads; a single
+ * instance must only be used by one thread at a time.
+ */
+typedef struct cts_monitor cts_monitor_t;
+
+/**
+ * @brief Packed binary edge event, same layout as the binary stream records
+ */
+typedef struct {
+    uint64_t time_ns;       /**< Edge time in nanoseconds since the epoch */
+    uint32_t sequence;      /**< Edge sequence number, counts from 0 */
+    uint8_t signal;         /**< signal_id_t of the edge */
+    uint8_t level;          /**< New level: 1 = HIGH, 0 = LOW */
+    uint16_t reserved;      /**< Zero */
+} cts_edge_event_t;
+
+/** Default number of edges per callback batch */
+#define CTS_MONITOR_DEFAULT_BATCH 256
+
+/** Maximum number of edges per callback batch */
+#define CTS_MONITOR_MAX_BATCH 1024
+
+/**
+ * @brief Edge batch callback
+ * @param events Edges in time order, valid only during the call
+ * @param count Number of edges
+ * @param user_data Pointer passed at registration
+ */
+typedef void (*cts_monitor_edge_callback_t)(const cts_edge_event_t *events, size_t count,
+                                            void *user_data);
+
+/**
+ * @brief Create and initialize a monitor
+ *
+ * Opens the capture backend and the outputs and reads the initial signal
+ * state.
+ *
+ * @param config Pointer to configuration structure (copied)
+ * @return Monitor instance, NULL on failure
  */
-int cts_monitor_init(const monitor_config_t *config);
+CTS_MONITOR_API cts_monitor_t *cts_monitor_create(const monitor_config_t *config);
 
 /**
  * @brief Start IRQ-driven monitoring (non-blocking)
+ * @param monitor Monitor instance
  * @return 0 on success, -1 on failure
  */
-int cts_monitor_start_irq(void);
+CTS_MONITOR_API int cts_monitor_start_irq(cts_monitor_t *monitor);
 
 /**
  * @brief Stop IRQ-driven monitoring
+ * @param monitor Monitor instance
  * @return 0 on success, -1 on failure
  */
-int cts_monitor_stop_irq(void);
+CTS_MONITOR_API int cts_monitor_stop_irq(cts_monitor_t *monitor);
 
 /**
  * @brief Update monitor (check for signal changes)
+ * @param monitor Monitor instance
  * @return 0 on success, -1 on failure
  */
-int cts_monitor_update(void);
+CTS_MONITOR_API int cts_monitor_update(cts_monitor_t *monitor);
 
 /**
  * @brief Process pending IRQ events
+ * @param monitor Monitor instance
  * @return Number of events processed, -1 on failure
  */
-int cts_monitor_process_irq_events(void);
+CTS_MONITOR_API int cts_monitor_process_irq_events(cts_monitor_t *monitor);
 
 /**
- * @brief Clean up and shutdown monitor
+ * @brief Check whether the capture source has run out of input
+ * @param monitor Monitor instance
+ * @return Non-zero once a replayed log has been fully processed or a
+ *         counted loopback test has completed
  */
-void cts_monitor_cleanup(void);
+CTS_MONITOR_API int cts_monitor_finished(const cts_monitor_t *monitor);
 
 /**
- * @brief Get current signal state
- * @param state Pointer to signal_state_t structure to fill
- * @return 0 on success, -1 on failure
+ * @brief Print final statistics, shut down the monitor and free it
+ * @param monitor Monitor instance
  */
-int cts_monitor_get_state(signal_state_t *state);
+CTS_MONITOR_API void cts_monitor_destroy(cts_monitor_t *monitor);
 
-#ifdef HAVE_LIBFTDI1
 /**
- * @brief Detect if device is an FTDI device
- * @param device_path Path to the serial device
- * @return 1 if FTDI device, 0 if not, -1 on error
+ * @brief Reopen the output file, e.g. after logrotate moved it away
+ *
+ * A plain output file is closed and reopened for appending; a fresh VCD or
+ * PCAP-NG file starts with a new header. Segmented outputs (rotation,
+ * mmap) name their own files and are left alone. With an output thread
+ * the switch is queued behind the records already waiting, which still
+ * go to the old file.
+ *
+ * @param monitor Monitor instance
+ * @return 0 on success, -1 if the file could not be reopened (writing continues to the old one)
  */
-int cts_monitor_is_ftdi_device(const char *device_path);
+CTS_MONITOR_API int cts_monitor_reopen_output(cts_monitor_t *monitor);
 
 /**
- * @brief Initialize FTDI-specific monitoring
- * @return 0 on success, -1 on failure
+ * @brief Get the settings currently in effect
+ * @param monitor Monitor instance
+ * @param settings Receives the settings; output_file stays valid until the next change
  */
-int cts_monitor_init_ftdi(void);
+CTS_MONITOR_API void cts_monitor_get_settings(const cts_monitor_t *monitor,
+                                              cts_monitor_settings_t *settings);
 
 /**
- * @brief Update FTDI device monitoring
+ * @brief Change settings without stopping the capture
+ *
+ * Call between two samples from the thread that samples. All settings
+ * are checked, and a new output file opened, before any of them takes
+ * effect, so a rejected change leaves the monitor as it was. The signal
+ * levels and all statistics carry over. A new output file is opened for
+ * appending and gets a header if it is empty; it can only be changed for
+ * unsegmented stdio output, and the signal set not for VCD output, whose
+ * header declares it.
+ *
+ * @param monitor Monitor instance
+ * @param settings New settings, e.g. from cts_monitor_get_settings() with changes
+ * @return 0 on success, -1 if the change was rejected (reason printed to stderr)
+ */
+CTS_MONITOR_API int cts_monitor_reconfigure(cts_monitor_t *monitor,
+                                            const cts_monitor_settings_t *settings);
+
+/**
+ * @brief Get current signal state
+ * @param monitor Monitor instance
+ * @param state Pointer to signal_state_t structure to fill
  * @return 0 on success, -1 on failure
  */
-int cts_monitor_update_ftdi(void);
+CTS_MONITOR_API int cts_monitor_get_state(cts_monitor_t *monitor, signal_state_t *state);
 
 /**
- * @brief Cleanup FTDI resources
+ * @brief Print pulse statistics, handshake summary and histogram percentiles collected so far
+ * @param monitor Monitor instance
+ * @param fp Destination stream
  */
-void cts_monitor_cleanup_ftdi(void);
-#endif
+CTS_MONITOR_API void cts_monitor_print_stats(cts_monitor_t *monitor, FILE *fp);
+
+/**
+ * @brief Register a callback receiving edges in batches
+ *
+ * Every detected edge is queued, independent of output format and trigger.
+ * A batch is delivered once batch_size edges are queued, with the first
+ * sample at least 10 ms after the oldest queued edge, on
+ * cts_monitor_flush_edges() and when the monitor is destroyed. The
+ * callback runs on the thread calling cts_monitor_update() or
+ * cts_monitor_process_irq_events().
+ *
+ * @param monitor Monitor instance
+ * @param callback Callback, or NULL to deliver pending edges and unregister
+ * @param user_data Passed to every call
+ * @param batch_size Maximum edges per call (0 for CTS_MONITOR_DEFAULT_BATCH,
+ *                   at most CTS_MONITOR_MAX_BATCH)
+ * @return 0 on success, -1 on an invalid batch size
+ */
+CTS_MONITOR_API int cts_monitor_set_edge_callback(cts_monitor_t *monitor,
+                                                  cts_monitor_edge_callback_t callback,
+                                                  void *user_data, size_t batch_size);
+
+/**
+ * @brief Deliver queued edges to the callback now
+ * @param monitor Monitor instance
+ */
+CTS_MONITOR_API void cts_monitor_flush_edges(cts_monitor_t *monitor);
 
 #endif /* CTS_MONITOR_H */
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/**
+ * @file daemon.h
+ * @brief Background operation for unattended captures
+ *
+ * Detaching double-forks into a new session. The starting process waits
+ * until the daemon reports whether initialization succeeded and exits
+ * with that status, so startup errors still reach the terminal and
+ * init scripts. The working directory is kept, so relative paths given
+ * on the command line stay valid.
+ */
+
+/** SCHED_FIFO priority of the capture thread in daemon mode */
+#define DAEMON_DEFAULT_PRIORITY 10
+
+/** Nice value used when real-time scheduling is not permitted */
+#define DAEMON_FALLBACK_NICE -10
+
+/**
+ * @brief Daemon state
+ */
+typedef struct {
+    int ready_fd;           /**< Pipe to the waiting parent, -1 once reported */
+    int pid_fd;             /**< Locked pidfile, -1 if none */
+    const char *pidfile;    /**< Pidfile path, NULL if none */
+} daemon_t;
+
+/**
+ * @brief Detach from the terminal
+ *
+ * Only the daemon returns; the starting process exits with the status
+ * passed to daemon_ready().
+ *
+ * @param daemon Receives the daemon state
+ * @return 0 in the daemon, -1 if detaching failed (still attached)
+ */
+int daemon_detach(daemon_t *daemon);
+
+/**
+ * @brief Write and lock the pidfile
+ * @param daemon Daemon state
+ * @param path Pidfile path
+ * @return 0 on success, -1 if another instance holds it or it cannot be written
+ */
+int daemon_write_pidfile(daemon_t *daemon, const char *path);
+
+/**
+ * @brief Report the startup result to the waiting parent
+ *
+ * On success stdin, stdout and stderr are redirected to /dev/null.
+ *
+ * @param daemon Daemon state
+ * @param ok Non-zero if initialization succeeded
+ */
+void daemon_ready(daemon_t *daemon, int ok);
+
+/**
+ * @brief Remove the pidfile
+ * @param daemon Daemon state
+ */
+void daemon_cleanup(daemon_t *daemon);
+
+/**
+ * @brief Run the calling thread with real-time priority
+ *
+ * Uses SCHED_FIFO at the given priority; without permission for it the
+ * thread gets DAEMON_FALLBACK_NICE instead, if allowed. Threads created
+ * earlier keep their priority.
+ *
+ * @param priority SCHED_FIFO priority (1-99)
+ * @return 0 if the priority was raised either way, -1 otherwise
+ */
+int daemon_raise_priority(int priority);
+
+#endif /* DAEMON_H */
@@ -0,0 +1,92 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+/**
+ * @file generator.h
+ * @brief RTS/DTR pattern generator
+ *
+ * Plays a pattern file on the output lines of a capture backend. Every
+ * transition is scheduled on an absolute CLOCK_MONOTONIC deadline, so
+ * timing errors do not accumulate over the pattern. The error between the
+ * requested and the achieved transition time is reported per transition
+ * and summarized in a histogram.
+ *
+ * Pattern file: one transition per line, '#' starts a comment.
+ *   RTS=1 DTR=0 10ms    set the named lines, then hold for the duration
+ *   RTS=0 2.5ms         lines not named keep their level
+ * Levels are 0/1 or LOW/HIGH. Durations take an ns, us, ms or s suffix
+ * (default us).
+ */
+
+#include <stdio.h>
+#include "capture_backend.h"
+#include "hdr_histogram.h"
+
+/**
+ * @brief One pattern transition
+ */
+typedef struct {
+    int mask;               /**< Lines written, bit per signal_id_t */
+    int levels;             /**< Levels of the written lines, bit per signal_id_t */
+    long long duration_ns;  /**< Time until the next transition */
+} generator_step_t;
+
+/**
+ * @brief Loaded pattern
+ */
+typedef struct {
+    generator_step_t *steps;    /**< Transitions in file order */
+    size_t count;               /**< Number of transitions */
+    size_t capacity;            /**< Allocated transitions */
+    long long length_ns;        /**< Duration of one pass */
+} generator_pattern_t;
+
+/**
+ * @brief Timing fidelity of a run
+ */
+typedef struct {
+    unsigned long long transitions; /**< Transitions written */
+    unsigned long long overruns;    /**< Transitions written after the next deadline had passed */
+    hdr_histogram_t error;          /**< Achieved minus requested transition time */
+} generator_stats_t;
+
+/**
+ * @brief Load a pattern file
+ * @param pattern Receives the pattern
+ * @param path Pattern file
+ * @return 0 on success, -1 on failure (errors are printed with the line number)
+ */
+int generator_load(generator_pattern_t *pattern, const char *path);
+
+/**
+ * @brief Free a loaded pattern
+ * @param pattern Pattern
+ */
+void generator_free(generator_pattern_t *pattern);
+
+/**
+ * @brief Play a pattern on the output lines
+ *
+ * Writes one report line per transition with the requested and achieved
+ * time relative to the start of the run and the error between them.
+ *
+ * @param pattern Pattern to play
+ * @param backend Open backend with set_lines support
+ * @param repeat Number of passes (0 = until stopped)
+ * @param report Per-transition report destination
+ * @param running Playback stops when this becomes zero
+ * @param stats Receives the timing statistics
+ * @return 0 on success or when stopped, -1 if a write failed
+ */
+int generator_run(const generator_pattern_t *pattern, capture_backend_t *backend,
+                  unsigned long repeat, FILE *report, volatile int *running,
+                  generator_stats_t *stats);
+
+/**
+ * @brief Print the timing error summary
+ * @param stats Timing statistics
+ * @param fp Destination stream
+ */
+void generator_print(const generator_stats_t *stats, FILE *fp);
+
+#endif /* GENERATOR_H */
@@ -0,0 +1,94 @@
+#ifndef GLITCH_FILTER_H
+#define GLITCH_FILTER_H
+
+/**
+ * @file glitch_filter.h
+ * @brief Per-signal minimum-pulse filter for the edge path
+ *
+ * Raw changes are held back until the new level has persisted for the
+ * signal's minimum pulse width. Pulses that revert earlier are dropped and
+ * counted. Committed edges keep the time of the sample that first saw
+ * them. Edges due at the same sample are released oldest first; with
+ * different widths per signal, an edge may be released after a younger
+ * edge on a faster signal.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/**
+ * @brief Filter state of one signal
+ */
+typedef struct {
+    long long min_pulse_ns;         /**< Minimum pulse width (0 = pass through) */
+    int committed;                  /**< Last level passed on to the log */
+    int pending;                    /**< Non-zero while a change is being held back */
+    struct timespec pending_time;   /**< Sample time of the held-back change */
+    unsigned long long suppressed;  /**< Pulses dropped as glitches */
+    unsigned long long passed;      /**< Edges passed on to the log */
+} glitch_channel_t;
+
+/**
+ * @brief Glitch filter state of all signals
+ */
+typedef struct {
+    glitch_channel_t channels[SIGNAL_COUNT];    /**< Indexed by signal_id_t */
+} glitch_filter_t;
+
+/**
+ * @brief Reset the filter
+ * @param gf Filter state
+ * @param min_pulse_us Minimum pulse width per signal in microseconds
+ * @param initial Initial signal levels
+ */
+void glitch_filter_init(glitch_filter_t *gf, const long min_pulse_us[SIGNAL_COUNT],
+                        const signal_state_t *initial);
+
+/**
+ * @brief Feed the raw level of a signal from a new sample
+ * @param gf Filter state
+ * @param signal Sampled signal
+ * @param level Raw level: 1 = HIGH, 0 = LOW
+ * @param ts Sample time
+ */
+void glitch_filter_sample(glitch_filter_t *gf, signal_id_t signal, int level,
+                          const struct timespec *ts);
+
+/**
+ * @brief Restart filtering of one signal at a known level
+ *
+ * Drops a held-back change, e.g. when the signal stops or starts being
+ * monitored. The counters are kept.
+ *
+ * @param gf Filter state
+ * @param signal Signal to restart
+ * @param level Current raw level: 1 = HIGH, 0 = LOW
+ */
+void glitch_filter_restart(glitch_filter_t *gf, signal_id_t signal, int level);
+
+/**
+ * @brief Release the next edge whose level has been stable long enough
+ *
+ * Call until it returns 0 before feeding a new sample, so due changes are
+ * committed before their level can revert, and again afterwards to release
+ * pass-through signals.
+ *
+ * @param gf Filter state
+ * @param now Current sample time
+ * @param signal Receives the signal of the released edge
+ * @param new_state Receives the new level
+ * @param edge_time Receives the sample time the change was first seen
+ * @return 1 if an edge was released, 0 otherwise
+ */
+int glitch_filter_next(glitch_filter_t *gf, const struct timespec *now,
+                       signal_id_t *signal, int *new_state, struct timespec *edge_time);
+
+/**
+ * @brief Print suppressed glitch counters
+ * @param gf Filter state
+ * @param fp Destination stream
+ */
+void glitch_filter_print(const glitch_filter_t *gf, FILE *fp);
+
+#endif /* GLITCH_FILTER_H */
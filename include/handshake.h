@@ -0,0 +1,110 @@
+#ifndef HANDSHAKE_H
+#define HANDSHAKE_H
+
+/**
+ * @file handshake.h
+ * @brief RTS-to-CTS handshake latency analyzer
+ *
+ * Pairs each RTS assertion with the next CTS assertion and each RTS
+ * deassertion with the next CTS deassertion, computed inline from the
+ * edge stream. Latencies go into whole-run and per-minute histograms;
+ * requests left unanswered beyond the timeout are flagged once.
+ */
+
+#include <time.h>
+#include "cts_monitor.h"
+#include "hdr_histogram.h"
+
+/** Handshake directions */
+typedef enum {
+    HANDSHAKE_ASSERT,       /**< RTS↑ answered by CTS↑ */
+    HANDSHAKE_DEASSERT,     /**< RTS↓ answered by CTS↓ */
+    HANDSHAKE_DIRECTIONS    /**< Number of directions */
+} handshake_direction_t;
+
+/**
+ * @brief State of one handshake direction
+ */
+typedef struct {
+    struct timespec request_time;   /**< Time of the pending RTS edge */
+    int pending;                    /**< Non-zero while waiting for CTS */
+    int timed_out;                  /**< Non-zero once the pending request was flagged */
+    unsigned long long pairs;       /**< Completed request/response pairs */
+    unsigned long long timeouts;    /**< Requests flagged as timed out */
+    unsigned long long unanswered;  /**< Requests superseded before CTS responded */
+    hdr_histogram_t latency;        /**< Whole-run response latencies */
+    hdr_histogram_t minute_latency; /**< Response latencies of the current minute */
+    unsigned long minute_timeouts;  /**< Timeouts in the current minute */
+} handshake_channel_t;
+
+/**
+ * @brief Handshake analyzer state
+ */
+typedef struct {
+    long long timeout_ns;                               /**< Timeout threshold (0 = never) */
+    long minute;                                        /**< Current wall-clock minute */
+    handshake_channel_t channels[HANDSHAKE_DIRECTIONS]; /**< Indexed by handshake_direction_t */
+} handshake_t;
+
+/**
+ * @brief Reset the analyzer
+ * @param hs Analyzer state
+ * @param timeout_ns Timeout threshold in nanoseconds (0 = never time out)
+ */
+void handshake_init(handshake_t *hs, long long timeout_ns);
+
+/**
+ * @brief Feed an edge into the analyzer
+ * @param hs Analyzer state
+ * @param signal Signal that changed
+ * @param new_state New signal state: 1 = HIGH, 0 = LOW
+ * @param ts Time of the edge
+ * @return Response latency in nanoseconds if the edge completed a pair, -1 otherwise
+ */
+long long handshake_edge(handshake_t *hs, signal_id_t signal, int new_state,
+                         const struct timespec *ts);
+
+/**
+ * @brief Forget pending requests without counting them as unanswered
+ *
+ * Used when RTS or CTS leaves the monitored set, so a request from before
+ * is never paired with a response seen after it rejoins.
+ *
+ * @param hs Analyzer state
+ */
+void handshake_cancel(handshake_t *hs);
+
+/**
+ * @brief Check pending requests against the timeout
+ *
+ * Each pending request is reported at most once.
+ *
+ * @param hs Analyzer state
+ * @param now Current sample time
+ * @param direction Receives the direction of a newly timed-out request
+ * @return 1 if a request newly timed out, 0 otherwise
+ */
+int handshake_check_timeout(handshake_t *hs, const struct timespec *now,
+                            handshake_direction_t *direction);
+
+/**
+ * @brief Check whether a wall-clock minute has completed
+ *
+ * When it returns 1 the per-minute histograms and counters describe the
+ * completed minute; call handshake_minute_reset() after reporting them.
+ *
+ * @param hs Analyzer state
+ * @param now Current sample time
+ * @param minute_start Receives the start of the completed minute
+ * @return 1 if a minute with activity completed, 0 otherwise
+ */
+int handshake_minute_due(handshake_t *hs, const struct timespec *now,
+                         struct timespec *minute_start);
+
+/**
+ * @brief Clear the per-minute histograms and counters
+ * @param hs Analyzer state
+ */
+void handshake_minute_reset(handshake_t *hs);
+
+#endif /* HANDSHAKE_H */
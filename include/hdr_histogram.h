@@ -0,0 +1,102 @@
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+/**
+ * @file hdr_histogram.h
+ * @brief Fixed-memory log-linear histogram
+ *
+ * Records nanosecond durations into 2^(HDR_SUB_BUCKET_BITS-1) linear
+ * sub-buckets per power of two, giving a relative error below 1/64 over
+ * the whole range up to 2^HDR_MAX_VALUE_BITS ns (about 4.9 hours). All
+ * storage lives inside the structure, recording never allocates.
+ *
+ * Histograms serialize to a compact, endian-independent binary blob;
+ * blobs of the same name can be merged across ports and runs.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** Sub-bucket resolution: values below 2^HDR_SUB_BUCKET_BITS are exact */
+#define HDR_SUB_BUCKET_BITS 7
+
+/** Largest trackable value is 2^HDR_MAX_VALUE_BITS - 1 ns, larger values are clamped */
+#define HDR_MAX_VALUE_BITS 44
+
+/** Number of counters in a histogram */
+#define HDR_BUCKET_COUNT ((HDR_MAX_VALUE_BITS - HDR_SUB_BUCKET_BITS + 2) << (HDR_SUB_BUCKET_BITS - 1))
+
+/** Maximum length of a histogram name in a blob */
+#define HDR_NAME_MAX 64
+
+/**
+ * @brief Log-linear histogram
+ */
+typedef struct {
+    uint64_t total;                     /**< Number of recorded values */
+    uint64_t min;                       /**< Smallest recorded value */
+    uint64_t max;                       /**< Largest recorded value */
+    uint64_t counts[HDR_BUCKET_COUNT];  /**< Per-bucket counts */
+} hdr_histogram_t;
+
+/**
+ * @brief Clear a histogram
+ * @param hist Histogram to clear
+ */
+void hdr_histogram_reset(hdr_histogram_t *hist);
+
+/**
+ * @brief Record a value
+ * @param hist Histogram
+ * @param value Value in nanoseconds
+ */
+void hdr_histogram_record(hdr_histogram_t *hist, uint64_t value);
+
+/**
+ * @brief Add all counts of one histogram to another
+ * @param dst Destination histogram
+ * @param src Source histogram
+ */
+void hdr_histogram_merge(hdr_histogram_t *dst, const hdr_histogram_t *src);
+
+/**
+ * @brief Value at a given percentile
+ * @param hist Histogram
+ * @param percentile Percentile (0.0 - 100.0)
+ * @return Highest value equivalent to the bucket holding the percentile
+ */
+uint64_t hdr_histogram_percentile(const hdr_histogram_t *hist, double percentile);
+
+/**
+ * @brief Print the header of a percentile table
+ * @param fp Destination stream
+ */
+void hdr_histogram_print_header(FILE *fp);
+
+/**
+ * @brief Print one percentile table row in microseconds
+ * @param hist Histogram
+ * @param name Row label
+ * @param fp Destination stream
+ */
+void hdr_histogram_print(const hdr_histogram_t *hist, const char *name, FILE *fp);
+
+/**
+ * @brief Append a named histogram to a binary blob
+ * @param fp Destination stream
+ * @param name Histogram name
+ * @param hist Histogram
+ * @return 0 on success, -1 on failure
+ */
+int hdr_histogram_write(FILE *fp, const char *name, const hdr_histogram_t *hist);
+
+/**
+ * @brief Read the next named histogram from a binary blob
+ * @param fp Source stream
+ * @param name Receives the histogram name (HDR_NAME_MAX bytes)
+ * @param hist Receives the histogram
+ * @return 1 if a histogram was read, 0 at end of file, -1 on malformed input
+ */
+int hdr_histogram_read(FILE *fp, char *name, hdr_histogram_t *hist);
+
+#endif /* HDR_HISTOGRAM_H */
@@ -0,0 +1,79 @@
+#ifndef LOG_PARSE_H
+#define LOG_PARSE_H
+
+/**
+ * @file log_parse.h
+ * @brief Parser for cts_monitor text logs
+ *
+ * Recognizes the record format written by the monitor:
+ *
+ *   [2025-09-24 14:30:16.456789] CTS: HIGH ↑     (absolute time format)
+ *   [1.333333] CTS: HIGH ↑                       (relative time format)
+ *
+ * Lines that carry a timestamp but no signal edge (start/stop banners,
+ * initial state) are reported as non-edge records.
+ */
+
+#include <stddef.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/**
+ * @brief Parsed log record
+ */
+typedef struct {
+    long long time_us;      /**< Timestamp in microseconds (epoch, or since start if relative) */
+    int relative;           /**< Non-zero if the timestamp is relative to the monitor start */
+    int is_edge;            /**< Non-zero if the record is a signal edge */
+    signal_id_t signal;     /**< Signal that changed (edges only) */
+    int state;              /**< New signal state: 1 = HIGH, 0 = LOW (edges only) */
+} log_record_t;
+
+/**
+ * @brief Parser state
+ *
+ * Caches the epoch of the last date and hour seen so that absolute
+ * timestamps do not need a mktime() call per line.
+ */
+typedef struct {
+    char cached_hour[13];   /**< "YYYY-MM-DD HH" of the cached epoch */
+    time_t cached_epoch;    /**< Epoch of the start of the cached hour */
+} log_parser_t;
+
+/**
+ * @brief Initialize parser state
+ * @param parser Parser to initialize
+ */
+void log_parser_init(log_parser_t *parser);
+
+/**
+ * @brief Parse a timestamp in either time format
+ * @param parser Parser state
+ * @param text Timestamp text (not necessarily NUL-terminated)
+ * @param len Length of the timestamp text
+ * @param time_us Receives the timestamp in microseconds
+ * @param relative Receives non-zero for relative timestamps
+ * @return 0 on success, -1 if the text is not a timestamp
+ */
+int log_parse_time(log_parser_t *parser, const char *text, size_t len,
+                   long long *time_us, int *relative);
+
+/**
+ * @brief Parse one log line
+ * @param parser Parser state
+ * @param line Start of the line (not necessarily NUL-terminated)
+ * @param len Length of the line without the newline
+ * @param record Receives the parsed record
+ * @return 0 on success, -1 if the line carries no timestamp
+ */
+int log_parse_line(log_parser_t *parser, const char *line, size_t len, log_record_t *record);
+
+/**
+ * @brief Look up a signal by name
+ * @param name Signal name (CTS, RTS, DSR or DTR, case-insensitive)
+ * @param len Length of the name
+ * @return Signal identifier, SIGNAL_COUNT if unknown
+ */
+signal_id_t log_parse_signal(const char *name, size_t len);
+
+#endif /* LOG_PARSE_H */
@@ -0,0 +1,65 @@
+#ifndef LOG_ROTATE_H
+#define LOG_ROTATE_H
+
+/**
+ * @file log_rotate.h
+ * @brief Size- and time-based rotation of the stdio output file
+ *
+ * Writes <base>.0000, <base>.0001, ... and starts a new segment once the
+ * current one reaches the size limit or a wall-clock period boundary is
+ * crossed. Every closed segment is recorded in the segment index.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <time.h>
+#include "segment_index.h"
+
+/**
+ * @brief Rotating output file state
+ */
+typedef struct {
+    const char *base_path;          /**< Base path, segment number is appended */
+    unsigned long long max_bytes;   /**< Size limit per segment (0 = unlimited) */
+    long period_s;                  /**< Rotation period in seconds (0 = none) */
+    unsigned int segment_number;    /**< Number of the current segment */
+    long period;                    /**< Period number of the current segment */
+    FILE *fp;                       /**< Stream of the current segment */
+    struct timespec pending_ts;     /**< Timestamp of the record being written */
+    segment_stats_t stats;          /**< Statistics of the current segment */
+} log_rotate_t;
+
+/**
+ * @brief Open the first segment and create the segment index
+ * @param rot Rotation state to initialize
+ * @param base_path Base path for segment files
+ * @param max_bytes Size limit per segment (0 = unlimited)
+ * @param period_s Rotation period in seconds (0 = none)
+ * @return 0 on success, -1 on failure
+ */
+int log_rotate_open(log_rotate_t *rot, const char *base_path,
+                    unsigned long long max_bytes, long period_s);
+
+/**
+ * @brief Get the stream for the next record, rotating if required
+ * @param rot Rotation state
+ * @param ts Timestamp of the record
+ * @return Stream to write to, NULL on failure
+ */
+FILE *log_rotate_begin(log_rotate_t *rot, const struct timespec *ts);
+
+/**
+ * @brief Account a record written after log_rotate_begin()
+ * @param rot Rotation state
+ * @param len Length of the record in bytes
+ * @param is_edge Non-zero if the record is a signal edge
+ */
+void log_rotate_end(log_rotate_t *rot, size_t len, int is_edge);
+
+/**
+ * @brief Close the current segment and record it in the index
+ * @param rot Rotation state
+ */
+void log_rotate_close(log_rotate_t *rot);
+
+#endif /* LOG_ROTATE_H */
@@ -0,0 +1,150 @@
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+/**
+ * @file loopback.h
+ * @brief Round-trip latency test over a loopback plug
+ *
+ * The monitor drives RTS and DTR through the capture backend following a
+ * pattern and times how long the looped-back edge takes to show up on
+ * CTS and DSR respectively. Every write is timestamped, so the measured
+ * latency covers the line driver, the plug, the device and the detection
+ * path of the selected monitor mode.
+ *
+ * Pattern syntax: ','-separated steps applied cyclically at the configured
+ * rate, each naming the lines it toggles, joined with '+':
+ *   RTS            toggle RTS every step
+ *   RTS,DTR        toggle RTS and DTR alternately
+ *   RTS+DTR        toggle both lines together
+ * An echo must arrive before its line is toggled again; later echoes are
+ * counted as lost.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "cts_monitor.h"
+#include "hdr_histogram.h"
+
+/** Maximum number of ','-separated pattern steps */
+#define LOOPBACK_MAX_STEPS 32
+
+/** Loopback paths */
+typedef enum {
+    LOOPBACK_RTS_CTS,       /**< RTS driven, echoed on CTS */
+    LOOPBACK_DTR_DSR,       /**< DTR driven, echoed on DSR */
+    LOOPBACK_PATHS          /**< Number of paths */
+} loopback_path_t;
+
+/**
+ * @brief State of one loopback path
+ */
+typedef struct {
+    int level;                      /**< Level last driven on the output */
+    int echo_level;                 /**< Level last seen on the input */
+    int pending;                    /**< Non-zero while waiting for the echo */
+    struct timespec write_time;     /**< Time the pending write completed */
+    unsigned long long writes;      /**< Toggles written */
+    unsigned long long echoes;      /**< Echoes matched to a write */
+    unsigned long long lost;        /**< Writes whose echo did not arrive in time */
+    unsigned long long unexpected;  /**< Input edges without a pending write */
+    hdr_histogram_t latency;        /**< Write-to-detection latencies */
+} loopback_channel_t;
+
+/**
+ * @brief Loopback test state
+ */
+typedef struct {
+    int steps[LOOPBACK_MAX_STEPS];  /**< Bit per loopback_path_t toggled by each step */
+    int step_count;                 /**< Number of pattern steps */
+    int next_step;                  /**< Index of the next step to drive */
+    long long period_ns;            /**< Time between steps */
+    unsigned long long count;       /**< Steps to drive (0 = until stopped) */
+    unsigned long long driven;      /**< Steps driven so far */
+    struct timespec next_due;       /**< Deadline of the next step */
+    struct timespec last_write;     /**< Time of the last write */
+    loopback_channel_t channels[LOOPBACK_PATHS]; /**< Indexed by loopback_path_t */
+} loopback_t;
+
+/**
+ * @brief Set up a loopback test
+ * @param lb Test state
+ * @param pattern Pattern of toggled lines
+ * @param rate_hz Pattern steps per second
+ * @param count Steps to drive (0 = until stopped)
+ * @param initial Initial signal levels
+ * @param now Current sample time; the first step is due immediately
+ * @return 0 on success, -1 on an invalid pattern or rate
+ */
+int loopback_init(loopback_t *lb, const char *pattern, double rate_hz, unsigned long long count,
+                  const signal_state_t *initial, const struct timespec *now);
+
+/**
+ * @brief Take the next step if it is due
+ *
+ * Pending echoes of the toggled lines are counted as lost.
+ *
+ * @param lb Test state
+ * @param now Current sample time
+ * @param set_mask Receives the lines to raise, bit per signal_id_t
+ * @param clear_mask Receives the lines to lower, bit per signal_id_t
+ * @return 1 if lines should be written, 0 otherwise
+ */
+int loopback_due(loopback_t *lb, const struct timespec *now, int *set_mask, int *clear_mask);
+
+/**
+ * @brief Record the completion of a write from loopback_due()
+ * @param lb Test state
+ * @param set_mask Lines raised
+ * @param clear_mask Lines lowered
+ * @param write_time Time the write completed, on the sample clock
+ */
+void loopback_written(loopback_t *lb, int set_mask, int clear_mask,
+                      const struct timespec *write_time);
+
+/**
+ * @brief Match the looped-back inputs of a sample against pending writes
+ * @param lb Test state
+ * @param state Sampled signal levels
+ * @param ts Sample time
+ */
+void loopback_sample(loopback_t *lb, const signal_state_t *state, const struct timespec *ts);
+
+/**
+ * @brief Time until the next step is due
+ * @param lb Test state
+ * @param now Current time
+ * @return Nanoseconds until the next step, 0 if due, -1 once all steps were driven
+ */
+long long loopback_until_due(const loopback_t *lb, const struct timespec *now);
+
+/**
+ * @brief Check whether a counted test has completed
+ *
+ * Complete once all steps were driven and the last echoes arrived or one
+ * step period has passed since the last write; echoes still pending then
+ * are counted as lost.
+ *
+ * @param lb Test state
+ * @param now Current sample time
+ * @return 1 if complete, 0 otherwise
+ */
+int loopback_done(loopback_t *lb, const struct timespec *now);
+
+/**
+ * @brief Print counters and latency percentiles of the driven paths
+ * @param lb Test state
+ * @param mode Monitor mode name the latencies were measured with
+ * @param fp Destination stream
+ */
+void loopback_print(const loopback_t *lb, const char *mode, FILE *fp);
+
+/**
+ * @brief Histogram name of a path, e.g. "loopback.poll.RTS->CTS"
+ * @param path Loopback path
+ * @param mode Monitor mode name
+ * @param buffer Output buffer
+ * @param size Buffer size
+ */
+void loopback_path_name(loopback_path_t path, const char *mode, char *buffer, size_t size);
+
+#endif /* LOOPBACK_H */
@@ -0,0 +1,125 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/**
+ * @file metrics.h
+ * @brief Live monitor metrics in Prometheus text exposition format
+ *
+ * Counters are kept one per cache line so that updates from the capture
+ * path never share a line with unrelated data. The metrics server answers
+ * HTTP GET requests on a Unix socket or a localhost TCP port and is
+ * serviced without blocking from the capture loop.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "cts_monitor.h"
+#include "hdr_histogram.h"
+
+/** Maximum number of concurrent metrics connections */
+#define METRICS_MAX_CLIENTS 4
+
+/** Size of the exposition body buffer */
+#define METRICS_BODY_MAX 8192
+
+/**
+ * @brief Counter padded to a cache line
+ */
+typedef struct {
+    uint64_t value;         /**< Counter value */
+    char pad[56];           /**< Padding to 64 bytes */
+} metrics_counter_t;
+
+/**
+ * @brief Monitor metrics
+ */
+typedef struct {
+    metrics_counter_t samples;                  /**< Signal state samples taken */
+    metrics_counter_t edges[SIGNAL_COUNT];      /**< Edges per signal */
+    metrics_counter_t read_errors;              /**< Failed modem-status reads (ioctl) */
+    metrics_counter_t bytes_written;            /**< Output bytes written */
+    metrics_counter_t output_lag_ns;            /**< Edge-to-write delay of the last edge */
+    metrics_counter_t output_lag_max_ns;        /**< Largest edge-to-write delay */
+    metrics_counter_t interval_sum_ns;          /**< Sum of sample intervals */
+    struct timespec start_time;                 /**< Monitor start */
+    struct timespec last_sample;                /**< Time of the previous sample */
+    hdr_histogram_t sample_interval;            /**< Sample interval distribution (ns) */
+} monitor_metrics_t;
+
+/**
+ * @brief Connection waiting for its request to complete
+ */
+typedef struct {
+    int fd;                 /**< Client socket, -1 if unused */
+    char request[1024];     /**< Request bytes received so far (only the end matters) */
+    size_t request_len;     /**< Bytes in request */
+    struct timespec opened; /**< Time the connection was accepted */
+} metrics_client_t;
+
+/**
+ * @brief Metrics server state
+ */
+typedef struct {
+    char unix_path[108];    /**< Socket path for Unix endpoints, empty for TCP */
+    int listen_fd;          /**< Listening socket */
+    metrics_client_t clients[METRICS_MAX_CLIENTS]; /**< Pending connections */
+    char body[METRICS_BODY_MAX];    /**< Response body, formatted per scrape */
+} metrics_server_t;
+
+/**
+ * @brief Reset all metrics
+ * @param metrics Metrics to reset
+ * @param start Monitor start time
+ */
+void metrics_init(monitor_metrics_t *metrics, const struct timespec *start);
+
+/**
+ * @brief Count a sample and record the interval since the previous one
+ * @param metrics Metrics
+ * @param ts Sample time
+ */
+void metrics_sample(monitor_metrics_t *metrics, const struct timespec *ts);
+
+/**
+ * @brief Record the delay between an edge and its output
+ * @param metrics Metrics
+ * @param edge_time Time of the edge
+ * @param now Time the record was written
+ */
+void metrics_output_lag(monitor_metrics_t *metrics, const struct timespec *edge_time,
+                        const struct timespec *now);
+
+/**
+ * @brief Format metrics in Prometheus text exposition format
+ * @param metrics Metrics
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ * @return Length of the text (truncated to size - 1)
+ */
+size_t metrics_format(const monitor_metrics_t *metrics, char *buffer, size_t size);
+
+/**
+ * @brief Start listening for scrapes
+ * @param server Server state to initialize
+ * @param endpoint "unix:PATH", or a TCP port on 127.0.0.1 given as "PORT" or "127.0.0.1:PORT"
+ * @return 0 on success, -1 on failure
+ */
+int metrics_server_open(metrics_server_t *server, const char *endpoint);
+
+/**
+ * @brief Accept scrapes and answer completed requests without blocking
+ * @param server Server state
+ * @param metrics Metrics to serve
+ * @param now Current time
+ */
+void metrics_server_service(metrics_server_t *server, const monitor_metrics_t *metrics,
+                            const struct timespec *now);
+
+/**
+ * @brief Close all connections and the listening socket
+ * @param server Server state
+ */
+void metrics_server_close(metrics_server_t *server);
+
+#endif /* METRICS_H */
@@ -0,0 +1,91 @@
+#ifndef MMAP_CAPTURE_H
+#define MMAP_CAPTURE_H
+
+/**
+ * @file mmap_capture.h
+ * @brief Memory-mapped rolling capture file
+ *
+ * Preallocates fixed-size capture segments with fallocate(), maps them
+ * with mmap() and lets the caller format records directly into the
+ * mapping. Segments are named <base>.0000, <base>.0001, ... and are
+ * truncated to their used length when closed. Closed segments are
+ * recorded in the segment index.
+ */
+
+#include <stddef.h>
+#include <time.h>
+#include "segment_index.h"
+
+/** Default segment size (64 MiB) */
+#define MMAP_CAPTURE_DEFAULT_SEGMENT_SIZE (64UL * 1024 * 1024)
+
+/** Bytes written between asynchronous msync() calls */
+#define MMAP_CAPTURE_SYNC_BYTES (1024UL * 1024)
+
+/** Maximum time between asynchronous msync() calls in milliseconds */
+#define MMAP_CAPTURE_SYNC_INTERVAL_MS 1000
+
+/**
+ * @brief Memory-mapped capture state
+ */
+typedef struct {
+    const char *base_path;          /**< Base path, segment number is appended */
+    size_t segment_size;            /**< Preallocated size of each segment */
+    long period_s;                  /**< Rotation period in seconds (0 = none) */
+    long period;                    /**< Period number of the current segment */
+    unsigned int segment_number;    /**< Number of the current segment */
+    int fd;                         /**< File descriptor of the current segment */
+    char *map;                      /**< Mapping of the current segment */
+    size_t used;                    /**< Bytes committed in the current segment */
+    size_t synced;                  /**< Bytes handed to msync() so far */
+    struct timespec last_sync;      /**< Time of the last msync() */
+    struct timespec pending_ts;     /**< Timestamp of the reserved record */
+    segment_stats_t stats;          /**< Statistics of the current segment */
+} mmap_capture_t;
+
+/**
+ * @brief Open the first capture segment
+ * @param cap Capture state to initialize
+ * @param base_path Base path for segment files
+ * @param segment_size Segment size in bytes (0 for default)
+ * @param period_s Rotation period in seconds (0 = none)
+ * @return 0 on success, -1 on failure
+ */
+int mmap_capture_open(mmap_capture_t *cap, const char *base_path, size_t segment_size,
+                      long period_s);
+
+/**
+ * @brief Reserve space for a record in the current segment
+ *
+ * Rolls to a new segment if fewer than max_len bytes are left or the
+ * record falls into a new rotation period.
+ *
+ * @param cap Capture state
+ * @param max_len Maximum length of the record
+ * @param ts Timestamp of the record
+ * @return Pointer into the mapping, NULL on failure
+ */
+char *mmap_capture_reserve(mmap_capture_t *cap, size_t max_len, const struct timespec *ts);
+
+/**
+ * @brief Commit a record previously written via mmap_capture_reserve()
+ * @param cap Capture state
+ * @param len Actual length of the record
+ * @param is_edge Non-zero if the record is a signal edge
+ */
+void mmap_capture_commit(mmap_capture_t *cap, size_t len, int is_edge);
+
+/**
+ * @brief Close the current segment, record it in the index and open the next one
+ * @param cap Capture state
+ * @return 0 on success, -1 on failure
+ */
+int mmap_capture_roll(mmap_capture_t *cap);
+
+/**
+ * @brief Flush, truncate, index and close the current segment
+ * @param cap Capture state
+ */
+void mmap_capture_close(mmap_capture_t *cap);
+
+#endif /* MMAP_CAPTURE_H */
@@ -0,0 +1,100 @@
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+
+/**
+ * @file output_queue.h
+ * @brief Single-producer single-consumer queue of output records
+ *
+ * Hands edges, preformatted report lines and output file switches from
+ * the capture thread to the output thread, which formats and writes them.
+ * The queue is a power-of-two array of fixed-size records allocated up
+ * front; the producer never blocks or allocates and counts records that
+ * do not fit as dropped.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/** Default number of records, grown by the pre-trigger buffer size when a trigger is set */
+#define OUTPUT_QUEUE_DEFAULT_SLOTS 8192
+
+/** Maximum length of a text record including the terminator */
+#define OUTPUT_QUEUE_TEXT_MAX 256
+
+/** Record kinds */
+typedef enum {
+    OUTPUT_QUEUE_EDGE,      /**< Signal edge, formatted by the consumer */
+    OUTPUT_QUEUE_TEXT,      /**< Preformatted report line */
+    OUTPUT_QUEUE_SWITCH     /**< Continue in a new output stream */
+} output_queue_kind_t;
+
+/**
+ * @brief Queued record
+ */
+typedef struct {
+    struct timespec ts;             /**< Time of the edge or report */
+    uint8_t kind;                   /**< output_queue_kind_t */
+    uint8_t signal;                 /**< signal_id_t of an edge */
+    uint8_t level;                  /**< New level of an edge */
+    uint8_t timed;                  /**< Non-zero if the edge's write latency is recorded */
+    void *stream;                   /**< Opened FILE of a switch record */
+    char text[OUTPUT_QUEUE_TEXT_MAX]; /**< Report line of a text record */
+} output_queue_record_t;
+
+/**
+ * @brief Queue state
+ */
+typedef struct {
+    output_queue_record_t *records; /**< Record array */
+    size_t mask;                    /**< Number of records minus one */
+    unsigned long long dropped;     /**< Records lost to a full queue (producer) */
+    char pad[40];                   /**< Keeps the positions on their own cache lines */
+    size_t head;                    /**< Next record to fill (producer) */
+    size_t tail_cache;              /**< Producer's last view of tail */
+    char pad2[48];                  /**< Rest of the cache line */
+    size_t tail;                    /**< Next record to consume (consumer) */
+    char pad3[56];                  /**< Rest of the cache line */
+} output_queue_t;
+
+/**
+ * @brief Allocate a queue
+ * @param queue Queue to initialize
+ * @param slots Number of records, rounded up to a power of two (0 for default)
+ * @return 0 on success, -1 if out of memory
+ */
+int output_queue_init(output_queue_t *queue, size_t slots);
+
+/**
+ * @brief Free a queue
+ * @param queue Queue
+ */
+void output_queue_free(output_queue_t *queue);
+
+/**
+ * @brief Get the next free record (producer)
+ * @param queue Queue
+ * @return Record to fill, NULL if the queue is full (counted as dropped)
+ */
+output_queue_record_t *output_queue_reserve(output_queue_t *queue);
+
+/**
+ * @brief Publish the record from output_queue_reserve() (producer)
+ * @param queue Queue
+ */
+void output_queue_commit(output_queue_t *queue);
+
+/**
+ * @brief Get the oldest queued record (consumer)
+ * @param queue Queue
+ * @return Record, NULL if the queue is empty
+ */
+const output_queue_record_t *output_queue_peek(output_queue_t *queue);
+
+/**
+ * @brief Release the record from output_queue_peek() (consumer)
+ * @param queue Queue
+ */
+void output_queue_release(output_queue_t *queue);
+
+#endif /* OUTPUT_QUEUE_H */
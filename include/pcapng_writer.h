@@ -0,0 +1,66 @@
+#ifndef PCAPNG_WRITER_H
+#define PCAPNG_WRITER_H
+
+/**
+ * @file pcapng_writer.h
+ * @brief PCAP-NG block formatting for edge captures
+ *
+ * The capture is one section with one interface per serial port, using
+ * LINKTYPE_USER0 and nanosecond timestamps. Each edge is an Enhanced
+ * Packet Block carrying a 4-byte payload:
+ *
+ *   byte 0  payload version (1)
+ *   byte 1  signal: 0 = CTS, 1 = RTS, 2 = DSR, 3 = DTR
+ *   byte 2  new level: 1 = HIGH, 0 = LOW
+ *   byte 3  reserved (0)
+ *
+ * Informational text records become empty packets with a comment.
+ * Blocks use host byte order, as recorded in the section header.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/** Link type of the edge packets (LINKTYPE_USER0) */
+#define PCAPNG_LINKTYPE 147
+
+/** Version of the edge payload */
+#define PCAPNG_PAYLOAD_VERSION 1
+
+/**
+ * @brief Format the section header and the interface description
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ * @param interface_name Name of the serial port
+ * @return Length of the blocks, 0 if they do not fit
+ */
+size_t pcapng_format_header(void *buffer, size_t size, const char *interface_name);
+
+/**
+ * @brief Format an edge as an Enhanced Packet Block
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ * @param interface_id Interface of the serial port
+ * @param ts Time of the edge
+ * @param signal Signal that changed
+ * @param level New level
+ * @return Length of the block, 0 if it does not fit
+ */
+size_t pcapng_format_edge(void *buffer, size_t size, uint32_t interface_id,
+                          const struct timespec *ts, signal_id_t signal, int level);
+
+/**
+ * @brief Format a text record as an empty packet with a comment
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ * @param interface_id Interface of the serial port
+ * @param ts Time of the record
+ * @param text Comment text
+ * @return Length of the block, 0 if it does not fit
+ */
+size_t pcapng_format_comment(void *buffer, size_t size, uint32_t interface_id,
+                             const struct timespec *ts, const char *text);
+
+#endif /* PCAPNG_WRITER_H */
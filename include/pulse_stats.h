@@ -0,0 +1,97 @@
+#ifndef PULSE_STATS_H
+#define PULSE_STATS_H
+
+/**
+ * @file pulse_stats.h
+ * @brief Online pulse-width and period statistics
+ *
+ * Maintains per-signal high time, low time and period (rising edge to
+ * rising edge) with min/max/mean/stddev, updated incrementally from the
+ * edge stream using Welford's algorithm. No edges are stored.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/**
+ * @brief Running statistics of a duration in nanoseconds
+ */
+typedef struct {
+    unsigned long long count;   /**< Number of samples */
+    long long min_ns;           /**< Shortest duration */
+    long long max_ns;           /**< Longest duration */
+    double mean_ns;             /**< Running mean */
+    double m2;                  /**< Sum of squared deviations from the mean */
+} running_stat_t;
+
+/**
+ * @brief Per-signal pulse statistics
+ */
+typedef struct {
+    running_stat_t high;        /**< Time spent HIGH */
+    running_stat_t low;         /**< Time spent LOW */
+    running_stat_t period;      /**< Rising edge to rising edge */
+    struct timespec last_edge;  /**< Time of the previous edge */
+    struct timespec last_rise;  /**< Time of the previous rising edge */
+    int have_edge;              /**< Non-zero once an edge has been seen */
+    int have_rise;              /**< Non-zero once a rising edge has been seen */
+} signal_pulse_stats_t;
+
+/**
+ * @brief Pulse statistics of all monitored signals
+ */
+typedef struct {
+    signal_pulse_stats_t signals[SIGNAL_COUNT]; /**< Indexed by signal_id_t */
+} pulse_stats_t;
+
+/**
+ * @brief Reset all statistics
+ * @param stats Statistics to reset
+ */
+void pulse_stats_init(pulse_stats_t *stats);
+
+/**
+ * @brief Forget the previous edges of one signal
+ *
+ * The next edge starts a new phase instead of ending one that spans a
+ * time the signal was not monitored. Collected statistics are kept.
+ *
+ * @param stats Statistics
+ * @param signal Signal to restart
+ */
+void pulse_stats_restart(pulse_stats_t *stats, signal_id_t signal);
+
+/**
+ * @brief Account a signal edge
+ * @param stats Statistics to update
+ * @param signal Signal that changed
+ * @param new_state New signal state: 1 = HIGH, 0 = LOW
+ * @param ts Time of the edge
+ * @return Duration of the phase the edge ended in nanoseconds, -1 for the first edge
+ */
+long long pulse_stats_edge(pulse_stats_t *stats, signal_id_t signal, int new_state,
+                           const struct timespec *ts);
+
+/**
+ * @brief Add a duration to running statistics
+ * @param stat Running statistics
+ * @param duration_ns Duration in nanoseconds
+ */
+void running_stat_add(running_stat_t *stat, long long duration_ns);
+
+/**
+ * @brief Standard deviation of running statistics
+ * @param stat Running statistics
+ * @return Sample standard deviation in nanoseconds (0 for fewer than two samples)
+ */
+double running_stat_stddev(const running_stat_t *stat);
+
+/**
+ * @brief Print a statistics table
+ * @param stats Statistics to print
+ * @param fp Destination stream
+ */
+void pulse_stats_print(const pulse_stats_t *stats, FILE *fp);
+
+#endif /* PULSE_STATS_H */
@@ -0,0 +1,75 @@
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+/**
+ * @file segment_index.h
+ * @brief Index of closed capture segments
+ *
+ * Segmented outputs (rotated log files and mmap capture segments) append
+ * one line per closed segment to <base>.idx:
+ *
+ *   <segment path> <first timestamp> <last timestamp> <edge count> <bytes>
+ *
+ * Timestamps are seconds since the epoch with microsecond precision, so
+ * tools can pick the segments covering a time range without reading them.
+ */
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @brief Statistics of the segment currently being written
+ */
+typedef struct {
+    struct timespec first;      /**< Timestamp of the first record */
+    struct timespec last;       /**< Timestamp of the last record */
+    unsigned long edges;        /**< Number of signal edges */
+    unsigned long long bytes;   /**< Bytes written */
+    int records;                /**< Non-zero once a record has been written */
+} segment_stats_t;
+
+/**
+ * @brief Clear segment statistics
+ * @param stats Statistics to reset
+ */
+void segment_stats_reset(segment_stats_t *stats);
+
+/**
+ * @brief Account a record written to the current segment
+ * @param stats Segment statistics
+ * @param ts Timestamp of the record
+ * @param is_edge Non-zero if the record is a signal edge
+ * @param len Length of the record in bytes
+ */
+void segment_stats_record(segment_stats_t *stats, const struct timespec *ts, int is_edge, size_t len);
+
+/**
+ * @brief Compute the rotation period a timestamp falls into
+ *
+ * Periods are aligned to local wall-clock time, so a period of 3600 rotates
+ * on the hour and 86400 at local midnight.
+ *
+ * @param ts Timestamp (CLOCK_REALTIME)
+ * @param period_s Period length in seconds
+ * @return Period number
+ */
+long segment_period_number(const struct timespec *ts, long period_s);
+
+/**
+ * @brief Create an empty index file for a segmented output
+ * @param base_path Base path of the output
+ * @return 0 on success, -1 on failure
+ */
+int segment_index_create(const char *base_path);
+
+/**
+ * @brief Append a closed segment to the index file
+ * @param base_path Base path of the output
+ * @param segment_path Path of the closed segment
+ * @param stats Statistics of the closed segment
+ * @return 0 on success, -1 on failure
+ */
+int segment_index_append(const char *base_path, const char *segment_path,
+                         const segment_stats_t *stats);
+
+#endif /* SEGMENT_INDEX_H */
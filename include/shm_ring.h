@@ -0,0 +1,148 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+/**
+ * @file shm_ring.h
+ * @brief Shared-memory edge ring and reader API
+ *
+ * The monitor publishes every edge into a POSIX shared-memory object laid
+ * out as a header followed by a power-of-two number of slots. Each slot
+ * carries the sequence number of the edge stored in it; the header holds
+ * the sequence number of the next edge. Readers map the object read-only,
+ * keep their own position and never block the writer: a reader that falls
+ * more than one ring behind sees the gap and skips ahead.
+ *
+ * Reader example:
+ *
+ *   shm_ring_reader_t reader;
+ *   shm_ring_edge_t edge;
+ *   uint64_t lost;
+ *   shm_ring_reader_open(&reader, "/cts_monitor");
+ *   for (;;) {
+ *       while (shm_ring_read(&reader, &edge, &lost) == 1) { ... }
+ *       usleep(1000);
+ *   }
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/** Marks the reader API, which libctsmonitor.so exports for consumers */
+#if defined(__GNUC__)
+#define SHM_RING_API __attribute__((visibility("default")))
+#else
+#define SHM_RING_API
+#endif
+
+/** Layout identifier at the start of the shared object */
+#define SHM_RING_MAGIC "CTSRING1"
+
+/** Default number of slots */
+#define SHM_RING_DEFAULT_SLOTS 65536
+
+/**
+ * @brief Edge as seen by readers
+ */
+typedef struct {
+    uint64_t sequence;      /**< Edge sequence number, counts from 0 */
+    uint64_t time_ns;       /**< Edge time in nanoseconds since the epoch */
+    uint8_t signal;         /**< Signal: 0 = CTS, 1 = RTS, 2 = DSR, 3 = DTR */
+    uint8_t level;          /**< New level: 1 = HIGH, 0 = LOW */
+} shm_ring_edge_t;
+
+/**
+ * @brief Slot in the shared ring
+ */
+typedef struct {
+    uint64_t sequence;      /**< Sequence of the stored edge, UINT64_MAX while being written */
+    uint64_t time_ns;       /**< Edge time in nanoseconds since the epoch */
+    uint32_t edge;          /**< Signal in bits 0-7, level in bits 8-15 */
+    uint32_t reserved;      /**< Zero */
+} shm_ring_slot_t;
+
+/**
+ * @brief Header of the shared object
+ */
+typedef struct {
+    char magic[8];          /**< SHM_RING_MAGIC */
+    uint32_t slot_count;    /**< Number of slots (power of two) */
+    uint32_t slot_size;     /**< sizeof(shm_ring_slot_t) */
+    char pad[48];           /**< Keeps the write position on its own cache line */
+    uint64_t next_sequence; /**< Sequence number of the next edge to be written */
+    char pad2[56];          /**< Rest of the cache line */
+} shm_ring_header_t;
+
+/**
+ * @brief Writer state (monitor side)
+ */
+typedef struct {
+    const char *name;           /**< Shared-memory object name */
+    shm_ring_header_t *header;  /**< Mapped header */
+    shm_ring_slot_t *slots;     /**< Mapped slots */
+    size_t map_size;            /**< Size of the mapping */
+    uint64_t next_sequence;     /**< Private copy of the write position */
+} shm_ring_writer_t;
+
+/**
+ * @brief Reader state
+ */
+typedef struct {
+    const shm_ring_header_t *header;    /**< Mapped header */
+    const shm_ring_slot_t *slots;       /**< Mapped slots */
+    size_t map_size;                    /**< Size of the mapping */
+    uint64_t next_sequence;             /**< Next edge this reader expects */
+} shm_ring_reader_t;
+
+/**
+ * @brief Create (or replace) the shared ring
+ * @param writer Writer state to initialize
+ * @param name Shared-memory object name, e.g. "/cts_monitor"
+ * @param slot_count Number of slots, rounded up to a power of two (0 for default)
+ * @return 0 on success, -1 on failure
+ */
+int shm_ring_writer_open(shm_ring_writer_t *writer, const char *name, size_t slot_count);
+
+/**
+ * @brief Publish an edge
+ * @param writer Writer state
+ * @param ts Time of the edge
+ * @param signal Signal that changed
+ * @param level New level
+ */
+void shm_ring_publish(shm_ring_writer_t *writer, const struct timespec *ts, int signal, int level);
+
+/**
+ * @brief Unmap and remove the shared ring
+ * @param writer Writer state
+ */
+void shm_ring_writer_close(shm_ring_writer_t *writer);
+
+/**
+ * @brief Map an existing ring read-only
+ *
+ * The reader starts at the current write position, i.e. with the next
+ * edge published after this call.
+ *
+ * @param reader Reader state to initialize
+ * @param name Shared-memory object name
+ * @return 0 on success, -1 on failure
+ */
+SHM_RING_API int shm_ring_reader_open(shm_ring_reader_t *reader, const char *name);
+
+/**
+ * @brief Read the next edge without blocking
+ * @param reader Reader state
+ * @param edge Receives the edge
+ * @param lost Receives the number of edges overwritten before they were read
+ * @return 1 if an edge was read, 0 if no new edge is available
+ */
+SHM_RING_API int shm_ring_read(shm_ring_reader_t *reader, shm_ring_edge_t *edge, uint64_t *lost);
+
+/**
+ * @brief Unmap the ring
+ * @param reader Reader state
+ */
+SHM_RING_API void shm_ring_reader_close(shm_ring_reader_t *reader);
+
+#endif /* SHM_RING_H */
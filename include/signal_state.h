@@ -0,0 +1,76 @@
+#ifndef SIGNAL_STATE_H
+#define SIGNAL_STATE_H
+
+/**
+ * @file signal_state.h
+ * @brief Decoding and comparison of signal samples
+ *
+ * These run once per sample on the capture path, so they are kept free of
+ * monitor state and can be benchmarked on their own (see bench/).
+ */
+
+#include "cts_monitor.h"
+
+/**
+ * @brief Order in which the changes of one sample are logged
+ *
+ * RTS goes ahead of CTS, so a handshake that completes within one sample
+ * reaches the analyzer as request and response rather than the reverse.
+ */
+extern const signal_id_t signal_state_log_order[SIGNAL_COUNT];
+
+/**
+ * @brief Decode the modem line bits returned by TIOCMGET
+ * @param status TIOCM_* bit mask
+ * @param state Receives the signal levels
+ */
+void signal_state_decode(int status, signal_state_t *state);
+
+/**
+ * @brief Encode signals as modem line bits for TIOCMBIS/TIOCMBIC
+ * @param mask Bit per signal_id_t
+ * @return TIOCM_* bit mask
+ */
+int signal_state_encode(int mask);
+
+/**
+ * @brief Level of one signal
+ * @param state Signal levels
+ * @param signal Signal to look up
+ * @return 1 = HIGH, 0 = LOW
+ */
+int signal_state_level(const signal_state_t *state, signal_id_t signal);
+
+/**
+ * @brief Set the level of one signal
+ * @param state Signal levels
+ * @param signal Signal to set
+ * @param level 1 = HIGH, 0 = LOW
+ */
+void signal_state_set(signal_state_t *state, signal_id_t signal, int level);
+
+/**
+ * @brief Find the signals that changed between two samples
+ * @param previous Levels of the previous sample
+ * @param current Levels of the current sample
+ * @param mask Bit per signal_id_t to compare
+ * @return Bit per changed signal, limited to mask
+ */
+int signal_state_changes(const signal_state_t *previous, const signal_state_t *current, int mask);
+
+/**
+ * @brief Parse a comma-separated signal list such as "CTS,RTS" or "all"
+ * @param text Signal names, case-insensitive
+ * @return Bit per signal_id_t, -1 if a name is unknown or the list is empty
+ */
+int signal_state_parse_mask(const char *text);
+
+/**
+ * @brief Format a signal set as a comma-separated list
+ * @param mask Bit per signal_id_t
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ */
+void signal_state_format_mask(int mask, char *buffer, size_t size);
+
+#endif /* SIGNAL_STATE_H */
@@ -0,0 +1,109 @@
+#ifndef STREAM_SERVER_H
+#define STREAM_SERVER_H
+
+/**
+ * @file stream_server.h
+ * @brief Unix-domain socket server for live edge subscribers
+ *
+ * Clients connect to a SOCK_STREAM socket and send one line choosing the
+ * stream format, "text" or "binary". Every edge is then queued to each
+ * subscriber in a bounded per-client buffer and written without blocking;
+ * a subscriber whose buffer overflows is disconnected so it can never
+ * slow down the capture.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/** Maximum number of simultaneous clients */
+#define STREAM_SERVER_MAX_CLIENTS 16
+
+/** Default per-client queue size in bytes */
+#define STREAM_SERVER_DEFAULT_QUEUE (64 * 1024)
+
+/**
+ * @brief Binary stream record (host byte order)
+ */
+typedef struct {
+    uint64_t time_ns;       /**< Edge time in nanoseconds since the epoch */
+    uint32_t sequence;      /**< Edge sequence number, counts from 0 */
+    uint8_t signal;         /**< signal_id_t of the edge */
+    uint8_t level;          /**< New level: 1 = HIGH, 0 = LOW */
+    uint16_t reserved;      /**< Zero */
+} stream_edge_t;
+
+/** Client subscription states */
+typedef enum {
+    STREAM_CLIENT_FREE,     /**< Slot unused */
+    STREAM_CLIENT_PENDING,  /**< Connected, format not chosen yet */
+    STREAM_CLIENT_TEXT,     /**< Receiving text lines */
+    STREAM_CLIENT_BINARY    /**< Receiving stream_edge_t records */
+} stream_client_state_t;
+
+/**
+ * @brief Connected subscriber
+ */
+typedef struct {
+    int fd;                         /**< Client socket */
+    stream_client_state_t state;    /**< Subscription state */
+    char request[16];               /**< Partial subscription line */
+    size_t request_len;             /**< Bytes in request */
+    char *queue;                    /**< Circular output queue */
+    size_t head;                    /**< Offset of the oldest queued byte */
+    size_t count;                   /**< Queued bytes */
+} stream_client_t;
+
+/**
+ * @brief Server state
+ */
+typedef struct {
+    const char *path;               /**< Socket path */
+    int listen_fd;                  /**< Listening socket */
+    size_t queue_size;              /**< Per-client queue size */
+    uint32_t sequence;              /**< Sequence number of the next edge */
+    unsigned long disconnected;     /**< Clients dropped for falling behind */
+    stream_client_t clients[STREAM_SERVER_MAX_CLIENTS]; /**< Client slots */
+} stream_server_t;
+
+/**
+ * @brief Create the listening socket
+ *
+ * A stale socket file left at the path is replaced.
+ *
+ * @param server Server state to initialize
+ * @param path Socket path
+ * @param queue_size Per-client queue size in bytes (0 for default)
+ * @return 0 on success, -1 on failure
+ */
+int stream_server_open(stream_server_t *server, const char *path, size_t queue_size);
+
+/**
+ * @brief Accept clients, read subscriptions and flush queues
+ *
+ * Never blocks; call regularly from the capture loop.
+ *
+ * @param server Server state
+ */
+void stream_server_service(stream_server_t *server);
+
+/**
+ * @brief Queue an edge to all subscribers and try to send it right away
+ * @param server Server state
+ * @param ts Time of the edge
+ * @param signal Signal that changed
+ * @param level New level
+ * @param text Text line for text subscribers
+ * @param text_len Length of the text line
+ */
+void stream_server_publish(stream_server_t *server, const struct timespec *ts,
+                           signal_id_t signal, int level, const char *text, size_t text_len);
+
+/**
+ * @brief Disconnect all clients and remove the socket
+ * @param server Server state
+ */
+void stream_server_close(stream_server_t *server);
+
+#endif /* STREAM_SERVER_H */
@@ -0,0 +1,52 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+/**
+ * @file timestamp.h
+ * @brief Text timestamps of output records
+ */
+
+#include <stddef.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/**
+ * @brief Format a timestamp as written in text records
+ *
+ * Absolute: "YYYY-MM-DD HH:MM:SS.uuuuuu" in local time.
+ * Relative: "seconds.uuuuuu" since start, with a leading '-' before it.
+ *
+ * @param ts Time to format
+ * @param start Monitor start (relative format only)
+ * @param format Time format
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ */
+void timestamp_format(const struct timespec *ts, const struct timespec *start,
+                      time_format_t format, char *buffer, size_t size);
+
+/**
+ * @brief Nanoseconds elapsed between two timestamps
+ * @param from Earlier time
+ * @param to Later time
+ * @return to - from in nanoseconds, negative if to is earlier
+ */
+static inline long long elapsed_ns(const struct timespec *from, const struct timespec *to) {
+    return (long long)(to->tv_sec - from->tv_sec) * 1000000000LL + (to->tv_nsec - from->tv_nsec);
+}
+
+/**
+ * @brief Advance a timestamp
+ * @param ts Time to start from
+ * @param ns Nanoseconds to add (non-negative)
+ * @return ts + ns
+ */
+static inline struct timespec add_ns(const struct timespec *ts, long long ns) {
+    struct timespec result = *ts;
+    long long total = result.tv_nsec + ns;
+    result.tv_sec += (time_t)(total / 1000000000LL);
+    result.tv_nsec = (long)(total % 1000000000LL);
+    return result;
+}
+
+#endif /* TIMESTAMP_H */
@@ -0,0 +1,151 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+/**
+ * @file trigger.h
+ * @brief Logic-analyzer style trigger with pre/post-trigger capture
+ *
+ * While armed, edges only go into a fixed-size circular buffer. When the
+ * trigger expression fires, the buffered pre-trigger edges are handed back
+ * for writing and edges keep flowing to the output for the post-trigger
+ * window, after which the trigger re-arms with an empty buffer.
+ *
+ * Expression syntax (conditions separated by ',' fire independently):
+ *   SIG=LEVEL            edge into LEVEL
+ *   SIG=LEVEL>DURATION   LEVEL held longer than DURATION
+ *   SIG=LEVEL<DURATION   pulse at LEVEL ended before DURATION
+ *   ...&SIG=LEVEL        only while another signal is at LEVEL
+ * Durations are microseconds unless suffixed with us, ms or s.
+ */
+
+#include <stddef.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/** Default pre-trigger buffer size in edges */
+#define TRIGGER_DEFAULT_EDGES 10000
+
+/** Maximum number of ','-separated conditions */
+#define TRIGGER_MAX_CONDITIONS 8
+
+/** Trigger condition kinds */
+typedef enum {
+    TRIGGER_EDGE,       /**< Edge into the level */
+    TRIGGER_HELD,       /**< Level held longer than the width */
+    TRIGGER_SHORT       /**< Pulse at the level shorter than the width */
+} trigger_kind_t;
+
+/**
+ * @brief One trigger condition
+ */
+typedef struct {
+    trigger_kind_t kind;            /**< Condition kind */
+    signal_id_t signal;             /**< Signal the condition watches */
+    int level;                      /**< Level: 1 = HIGH, 0 = LOW */
+    long long width_ns;             /**< Pulse width for TRIGGER_HELD / TRIGGER_SHORT */
+    int qualifier_mask;             /**< Bit per signal that must be at a given level */
+    int qualifier_levels;           /**< Required levels of the qualifying signals */
+} trigger_condition_t;
+
+/**
+ * @brief Buffered edge event
+ */
+typedef struct {
+    struct timespec ts;             /**< Sample time of the edge */
+    unsigned char signal;           /**< signal_id_t of the edge */
+    unsigned char state;            /**< New level */
+} trigger_event_t;
+
+/**
+ * @brief Trigger state
+ */
+typedef struct {
+    trigger_condition_t conditions[TRIGGER_MAX_CONDITIONS]; /**< Parsed expression */
+    int condition_count;            /**< Number of conditions */
+    long long post_ns;              /**< Post-trigger window */
+    trigger_event_t *events;        /**< Circular pre-trigger buffer */
+    size_t capacity;                /**< Buffer capacity in edges */
+    size_t head;                    /**< Index of the oldest buffered edge */
+    size_t count;                   /**< Number of buffered edges */
+    int capturing;                  /**< Non-zero during the post-trigger window */
+    struct timespec fire_time;      /**< Time the trigger last fired */
+    int levels[SIGNAL_COUNT];       /**< Current level of each signal */
+    struct timespec since[SIGNAL_COUNT]; /**< Time of each signal's last edge */
+    int held_fired[SIGNAL_COUNT];   /**< Non-zero once a hold condition fired this phase */
+    unsigned long long fired;       /**< Number of times the trigger fired */
+} trigger_t;
+
+/**
+ * @brief Parse a duration with optional us, ms or s suffix
+ * @param text Duration text
+ * @param ns Receives the duration in nanoseconds
+ * @return 0 on success, -1 on failure
+ */
+int trigger_parse_duration(const char *text, long long *ns);
+
+/**
+ * @brief Set up a trigger
+ * @param trig Trigger state
+ * @param expression Trigger expression
+ * @param capacity Pre-trigger buffer size in edges
+ * @param post_ns Post-trigger window in nanoseconds
+ * @param initial Initial signal levels
+ * @param now Current time
+ * @return 0 on success, -1 on failure (invalid expression or out of memory)
+ */
+int trigger_init(trigger_t *trig, const char *expression, size_t capacity,
+                 long long post_ns, const signal_state_t *initial, const struct timespec *now);
+
+/**
+ * @brief Release the pre-trigger buffer
+ * @param trig Trigger state
+ */
+void trigger_free(trigger_t *trig);
+
+/**
+ * @brief Check whether the post-trigger window is open
+ *
+ * Re-arms the trigger with an empty buffer once the window has passed.
+ *
+ * @param trig Trigger state
+ * @param now Current time
+ * @return 1 if edges should be written directly, 0 if they should be fed to trigger_edge()
+ */
+int trigger_capturing(trigger_t *trig, const struct timespec *now);
+
+/**
+ * @brief Buffer an edge and evaluate edge-based conditions
+ * @param trig Trigger state
+ * @param signal Signal that changed
+ * @param new_state New level
+ * @param ts Time of the edge
+ * @return 1 if the trigger fired, 0 otherwise
+ */
+int trigger_edge(trigger_t *trig, signal_id_t signal, int new_state, const struct timespec *ts);
+
+/**
+ * @brief Track an edge written during the post-trigger window
+ * @param trig Trigger state
+ * @param signal Signal that changed
+ * @param new_state New level
+ * @param ts Time of the edge
+ */
+void trigger_track(trigger_t *trig, signal_id_t signal, int new_state, const struct timespec *ts);
+
+/**
+ * @brief Evaluate hold conditions between edges
+ * @param trig Trigger state
+ * @param now Current sample time
+ * @return 1 if the trigger fired, 0 otherwise
+ */
+int trigger_check(trigger_t *trig, const struct timespec *now);
+
+/**
+ * @brief Take the oldest buffered edge after the trigger fired
+ * @param trig Trigger state
+ * @param event Receives the edge
+ * @return 1 if an edge was returned, 0 once the buffer is empty
+ */
+int trigger_pop(trigger_t *trig, trigger_event_t *event);
+
+#endif /* TRIGGER_H */
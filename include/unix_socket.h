@@ -0,0 +1,22 @@
+#ifndef UNIX_SOCKET_H
+#define UNIX_SOCKET_H
+
+/**
+ * @file unix_socket.h
+ * @brief Listening Unix-domain sockets for the stream, control and metrics servers
+ */
+
+/**
+ * @brief Create a non-blocking listening SOCK_STREAM socket at a path
+ *
+ * A stale socket file left at the path is replaced. Errors are reported on
+ * stderr naming the socket by its purpose.
+ *
+ * @param path Socket path
+ * @param backlog Listen backlog
+ * @param name Purpose of the socket for error messages, e.g. "stream"
+ * @return Listening socket, or -1 on failure
+ */
+int unix_socket_listen(const char *path, int backlog, const char *name);
+
+#endif /* UNIX_SOCKET_H */
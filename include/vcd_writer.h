@@ -0,0 +1,73 @@
+#ifndef VCD_WRITER_H
+#define VCD_WRITER_H
+
+/**
+ * @file vcd_writer.h
+ * @brief Value Change Dump formatting for waveform viewers
+ *
+ * Each monitored signal is a one-bit wire; times are nanoseconds since
+ * the start of the capture. Records are formatted one at a time so the
+ * dump is streamed rather than assembled in memory.
+ */
+
+#include <stddef.h>
+#include <time.h>
+#include "cts_monitor.h"
+
+/**
+ * @brief VCD stream state
+ */
+typedef struct {
+    struct timespec start;      /**< Time zero of the dump */
+    long long last_time_ns;     /**< Last #time written (-1 before the first) */
+} vcd_writer_t;
+
+/**
+ * @brief Start a VCD stream
+ * @param vcd Stream state
+ * @param start Time zero of the dump
+ */
+void vcd_writer_init(vcd_writer_t *vcd, const struct timespec *start);
+
+/**
+ * @brief Identifier code of a signal's wire
+ * @param signal Signal
+ * @return Printable VCD identifier character
+ */
+char vcd_identifier(signal_id_t signal);
+
+/**
+ * @brief Format one declaration/header line
+ *
+ * Call with line = 0, 1, ... until it returns 0; wires are declared for
+ * the signals in signal_mask and dumped with their initial levels.
+ *
+ * @param vcd Stream state
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ * @param line Header line number
+ * @param signal_mask Bit per signal_id_t to declare
+ * @param initial Initial signal levels
+ * @return Length of the formatted line, 0 after the last line
+ */
+int vcd_format_header(vcd_writer_t *vcd, char *buffer, size_t size, int line,
+                      int signal_mask, const signal_state_t *initial);
+
+/**
+ * @brief Format a value change, preceded by #time when the time advanced
+ *
+ * Times never go backwards in the output; an edge older than the last
+ * written time is placed at that time.
+ *
+ * @param vcd Stream state
+ * @param buffer Destination buffer
+ * @param size Buffer size
+ * @param ts Time of the edge
+ * @param signal Signal that changed
+ * @param level New level
+ * @return Length of the formatted record
+ */
+int vcd_format_change(vcd_writer_t *vcd, char *buffer, size_t size,
+                      const struct timespec *ts, signal_id_t signal, int level);
+
+#endif /* VCD_WRITER_H */
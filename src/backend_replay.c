@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "capture_backend.h"
+#include "log_parse.h"
+#include "timestamp.h"
+
+typedef struct {
+    FILE *fp;                       /**< Log being replayed */
+    log_parser_t parser;            /**< Timestamp parser state */
+    char *line;                     /**< getline() buffer */
+    size_t line_size;               /**< Size of the getline() buffer */
+    double speed;                   /**< Timing multiple, 0 = as fast as possible */
+    int relative;                   /**< Non-zero for relative-time logs */
+    long long origin_us;            /**< Log time of the initial sample */
+    struct timespec wall_origin;    /**< Replay start, base of relative log times */
+    struct timespec pace_origin;    /**< Replay start on the monotonic clock */
+    signal_state_t levels;          /**< Levels after the edges applied so far */
+    log_record_t next;              /**< Next edge to apply */
+    int have_next;                  /**< Non-zero while next is valid */
+    int sampled;                    /**< Non-zero once the initial sample was taken */
+    unsigned long long edges;       /**< Edges applied */
+} replay_backend_t;
+
+static int *signal_level(signal_state_t *state, signal_id_t signal) {
+    switch (signal) {
+    case SIGNAL_CTS: return &state->cts;
+    case SIGNAL_RTS: return &state->rts;
+    case SIGNAL_DSR: return &state->dsr;
+    default:         return &state->dtr;
+    }
+}
+
+// Sample time of a log time
+static void log_time_to_ts(const replay_backend_t *replay, long long time_us, struct timespec *ts) {
+    long long ns = time_us * 1000LL;
+    if (replay->relative) {
+        ns += replay->wall_origin.tv_nsec;
+        ts->tv_sec = replay->wall_origin.tv_sec + (time_t)(ns / 1000000000LL);
+    } else {
+        ts->tv_sec = (time_t)(ns / 1000000000LL);
+    }
+    ts->tv_nsec = (long)(ns % 1000000000LL);
+}
+
+// Read ahead to the next edge record
+static void advance(replay_backend_t *replay) {
+    ssize_t len;
+    
+    replay->have_next = 0;
+    while ((len = getline(&replay->line, &replay->line_size, replay->fp)) > 0) {
+        if (log_parse_line(&replay->parser, replay->line, (size_t)len, &replay->next) == 0 &&
+            replay->next.is_edge) {
+            replay->have_next = 1;
+            return;
+        }
+    }
+}
+
+// Find the time origin and each signal's level before its first edge
+static int scan_log(replay_backend_t *replay, const char *path) {
+    log_record_t record;
+    int pending = (1 << SIGNAL_COUNT) - 1;
+    int started = 0;
+    ssize_t len;
+    
+    while (pending && (len = getline(&replay->line, &replay->line_size, replay->fp)) > 0) {
+        if (log_parse_line(&replay->parser, replay->line, (size_t)len, &record) < 0) {
+            continue;
+        }
+        if (!started) {
+            // Relative times count from the monitor start
+            replay->relative = record.relative;
+            replay->origin_us = record.relative ? 0 : record.time_us;
+            started = 1;
+        }
+        if (record.is_edge && (pending & (1 << record.signal))) {
+            *signal_level(&replay->levels, record.signal) = !record.state;
+            pending &= ~(1 << record.signal);
+        }
+    }
+    
+    if (pending == (1 << SIGNAL_COUNT) - 1) {
+        fprintf(stderr, "No signal edges in %s\n", path);
+        return -1;
+    }
+    rewind(replay->fp);
+    log_parser_init(&replay->parser);
+    return 0;
+}
+
+static int replay_open(capture_backend_t *backend, const monitor_config_t *config) {
+    const char *path = config->serial_device + 7;
+    
+    replay_backend_t *replay = calloc(1, sizeof(*replay));
+    if (!replay) {
+        fprintf(stderr, "Out of memory opening %s\n", path);
+        return -1;
+    }
+    
+    replay->fp = fopen(path, "r");
+    if (!replay->fp) {
+        fprintf(stderr, "Error opening replay log %s: %s\n", path, strerror(errno));
+        free(replay);
+        return -1;
+    }
+    
+    log_parser_init(&replay->parser);
+    if (scan_log(replay, path) < 0) {
+        fclose(replay->fp);
+        free(replay->line);
+        free(replay);
+        return -1;
+    }
+    
+    replay->speed = config->replay_speed;
+    clock_gettime(CLOCK_REALTIME, &replay->wall_origin);
+    clock_gettime(CLOCK_MONOTONIC, &replay->pace_origin);
+    advance(replay);
+    
+    if (backend->verbose) {
+        printf("Replaying %s (%s)\n", path, replay->speed > 0 ? "paced" : "as fast as possible");
+    }
+    backend->priv = replay;
+    return 0;
+}
+
+// Log time the paced replay has reached
+static long long paced_time_us(const replay_backend_t *replay) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return replay->origin_us + (long long)(elapsed_ns(&replay->pace_origin, &now) / 1000.0 * replay->speed);
+}
+
+static int replay_read_state(capture_backend_t *backend, signal_state_t *state, struct timespec *ts) {
+    replay_backend_t *replay = backend->priv;
+    
+    // The initial sample is taken before any edge is applied
+    if (!replay->sampled) {
+        replay->sampled = 1;
+        log_time_to_ts(replay, replay->origin_us, ts);
+        *state = replay->levels;
+        return 0;
+    }
+    if (!replay->have_next) {
+        return 1;
+    }
+    
+    if (replay->speed > 0) {
+        long long now_us = paced_time_us(replay);
+        if (now_us < replay->next.time_us) {
+            log_time_to_ts(replay, now_us, ts);
+            *state = replay->levels;
+            return 0;
+        }
+    }
+    
+    // Apply the edges of one timestamp; a second edge of the same signal
+    // is left for the next sample so the pulse is not lost
+    long long time_us = replay->next.time_us;
+    int changed = 0;
+    while (replay->have_next && replay->next.time_us == time_us &&
+           !(changed & (1 << replay->next.signal))) {
+        *signal_level(&replay->levels, replay->next.signal) = replay->next.state;
+        changed |= 1 << replay->next.signal;
+        replay->edges++;
+        advance(replay);
+    }
+    
+    log_time_to_ts(replay, time_us, ts);
+    *state = replay->levels;
+    return 0;
+}
+
+// Sleep until the next edge is due
+static int replay_wait_edge(capture_backend_t *backend, int timeout_ms) {
+    const replay_backend_t *replay = backend->priv;
+    
+    if (!replay->have_next || replay->speed <= 0) {
+        return 1;
+    }
+    
+    long long wait_ns = (long long)((replay->next.time_us - paced_time_us(replay)) * 1000.0 / replay->speed);
+    if (wait_ns <= 0) {
+        return 1;
+    }
+    
+    int due = wait_ns <= timeout_ms * 1000000LL;
+    if (!due) {
+        wait_ns = timeout_ms * 1000000LL;
+    }
+    struct timespec delay = { (time_t)(wait_ns / 1000000000LL), (long)(wait_ns % 1000000000LL) };
+    if (nanosleep(&delay, NULL) < 0 && errno == EINTR) {
+        return 0;
+    }
+    return due;
+}
+
+static void replay_close(capture_backend_t *backend) {
+    replay_backend_t *replay = backend->priv;
+    if (!replay) {
+        return;
+    }
+    
+    if (backend->verbose) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double seconds = elapsed_ns(&replay->pace_origin, &now) / 1e9;
+        printf("Replayed %llu edges in %.3f s (%.0f edges/s)\n", replay->edges, seconds,
+               seconds > 0 ? replay->edges / seconds : 0.0);
+    }
+    
+    fclose(replay->fp);
+    free(replay->line);
+    free(replay);
+    backend->priv = NULL;
+}
+
+const capture_backend_ops_t replay_backend_ops = {
+    .name = "replay",
+    .open = replay_open,
+    .read_state = replay_read_state,
+    .wait_edge = replay_wait_edge,
+    .close = replay_close
+};
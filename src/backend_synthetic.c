@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include "capture_backend.h"
+#include "timestamp.h"
+
+// Pattern generated when the device string has no SPEC
+#define SYNTHETIC_DEFAULT_SPEC "RTS=1k,CTS=RTS+100us"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+typedef enum {
+    SYNTH_CONSTANT,     /**< Fixed level */
+    SYNTH_SQUARE,       /**< Square wave starting HIGH at open time */
+    SYNTH_COPY,         /**< Delayed copy of another signal */
+    SYNTH_DRIVEN        /**< Level written through set_lines() */
+} synth_kind_t;
+
+typedef struct {
+    synth_kind_t kind;  /**< Pattern kind */
+    int level;          /**< Level of SYNTH_CONSTANT */
+    long long period_ns; /**< Period of SYNTH_SQUARE */
+    long long high_ns;  /**< HIGH time per period of SYNTH_SQUARE */
+    int source;         /**< Copied signal of SYNTH_COPY */
+    long long delay_ns; /**< Delay of SYNTH_COPY */
+    int previous;       /**< Level of SYNTH_DRIVEN before the last write */
+    long long written;  /**< Time of the last write of SYNTH_DRIVEN */
+} synth_signal_t;
+
+typedef struct {
+    synth_signal_t signals[SIGNAL_COUNT];   /**< Indexed by signal_id_t */
+    struct timespec start;                  /**< Time the generator started */
+    long long step_ns;                      /**< Virtual time per sample (0 = real clock) */
+    long long samples;                      /**< Samples taken on the virtual clock */
+} synthetic_backend_t;
+
+// Level of a signal t ns after the start; signals are LOW before the start
+static int signal_level(const synthetic_backend_t *synth, int signal, long long t) {
+    const synth_signal_t *sig = &synth->signals[signal];
+    
+    switch (sig->kind) {
+    case SYNTH_CONSTANT:
+        return sig->level;
+    case SYNTH_SQUARE:
+        return t >= 0 && t % sig->period_ns < sig->high_ns;
+    case SYNTH_COPY:
+        return signal_level(synth, sig->source, t - sig->delay_ns);
+    case SYNTH_DRIVEN:
+        return t >= sig->written ? sig->level : sig->previous;
+    }
+    return 0;
+}
+
+// Time of the next level change after t, -1 if the signal never changes
+static long long next_change(const synthetic_backend_t *synth, int signal, long long t) {
+    const synth_signal_t *sig = &synth->signals[signal];
+    
+    switch (sig->kind) {
+    case SYNTH_CONSTANT:
+        return -1;
+    case SYNTH_SQUARE: {
+        if (t < 0) {
+            return 0;
+        }
+        long long phase = t % sig->period_ns;
+        return t - phase + (phase < sig->high_ns ? sig->high_ns : sig->period_ns);
+    }
+    case SYNTH_COPY: {
+        long long next = next_change(synth, sig->source, t - sig->delay_ns);
+        return next < 0 ? -1 : next + sig->delay_ns;
+    }
+    case SYNTH_DRIVEN:
+        return t < sig->written ? sig->written : -1;
+    }
+    return -1;
+}
+
+static int parse_signal_name(const char *name, size_t len) {
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (len == strlen(signal_names[i]) && strncasecmp(name, signal_names[i], len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Parse "FREQ[/DUTY]" into a square wave, or a constant if the duty cycle is 0 or 100
+static int parse_square(const char *text, synth_signal_t *sig) {
+    char *end;
+    double freq = strtod(text, &end);
+    double duty = 50.0;
+    
+    if (end == text) {
+        return -1;
+    }
+    if (*end == 'k' || *end == 'K') {
+        freq *= 1e3;
+        end++;
+    } else if (*end == 'M') {
+        freq *= 1e6;
+        end++;
+    }
+    if (*end == '/') {
+        const char *duty_text = end + 1;
+        duty = strtod(duty_text, &end);
+        if (end == duty_text || duty < 0.0 || duty > 100.0) {
+            return -1;
+        }
+    }
+    if (*end != '\0' || freq <= 0.0 || freq > 5e8) {
+        return -1;
+    }
+    
+    sig->kind = SYNTH_SQUARE;
+    sig->period_ns = (long long)(1e9 / freq + 0.5);
+    sig->high_ns = (long long)(sig->period_ns * duty / 100.0 + 0.5);
+    if (sig->high_ns <= 0 || sig->high_ns >= sig->period_ns) {
+        sig->kind = SYNTH_CONSTANT;
+        sig->level = sig->high_ns > 0;
+    }
+    return 0;
+}
+
+// Parse a delay with ns, us, ms or s suffix (default us)
+static int parse_delay(const char *text, long long *ns) {
+    char *end;
+    double value = strtod(text, &end);
+    double scale;
+    
+    if (end == text || value < 0.0) {
+        return -1;
+    }
+    if (strcmp(end, "ns") == 0) {
+        scale = 1.0;
+    } else if (*end == '\0' || strcmp(end, "us") == 0) {
+        scale = 1e3;
+    } else if (strcmp(end, "ms") == 0) {
+        scale = 1e6;
+    } else if (strcmp(end, "s") == 0) {
+        scale = 1e9;
+    } else {
+        return -1;
+    }
+    *ns = (long long)(value * scale + 0.5);
+    return 0;
+}
+
+// Parse one "SIG=PATTERN" or "step=DELAY" term
+static int parse_term(synthetic_backend_t *synth, const char *term) {
+    const char *eq = strchr(term, '=');
+    if (!eq) {
+        return -1;
+    }
+    if (eq - term == 4 && strncasecmp(term, "step", 4) == 0) {
+        return parse_delay(eq + 1, &synth->step_ns) < 0 || synth->step_ns <= 0 ? -1 : 0;
+    }
+    int signal = parse_signal_name(term, (size_t)(eq - term));
+    if (signal < 0) {
+        return -1;
+    }
+    
+    synth_signal_t *sig = &synth->signals[signal];
+    const char *pattern = eq + 1;
+    const char *plus = strchr(pattern, '+');
+    
+    memset(sig, 0, sizeof(*sig));
+    if (plus) {
+        sig->kind = SYNTH_COPY;
+        sig->source = parse_signal_name(pattern, (size_t)(plus - pattern));
+        if (sig->source < 0 || sig->source == signal) {
+            return -1;
+        }
+        return parse_delay(plus + 1, &sig->delay_ns);
+    }
+    if (strcmp(pattern, "0") == 0 || strcmp(pattern, "1") == 0) {
+        sig->kind = SYNTH_CONSTANT;
+        sig->level = pattern[0] - '0';
+        return 0;
+    }
+    return parse_square(pattern, sig);
+}
+
+static int parse_spec(synthetic_backend_t *synth, const char *spec) {
+    char copy[256];
+    if (snprintf(copy, sizeof(copy), "%s", spec) >= (int)sizeof(copy)) {
+        return -1;
+    }
+    
+    for (char *term = copy; term; ) {
+        char *next = strchr(term, ',');
+        if (next) {
+            *next++ = '\0';
+        }
+        if (parse_term(synth, term) < 0) {
+            return -1;
+        }
+        term = next;
+    }
+    
+    // Copies of copies could form cycles
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (synth->signals[i].kind == SYNTH_COPY &&
+            synth->signals[synth->signals[i].source].kind == SYNTH_COPY) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int synthetic_open(capture_backend_t *backend, const monitor_config_t *config) {
+    const char *device = config->serial_device;
+    const char *spec = device[9] == ':' ? device + 10 : SYNTHETIC_DEFAULT_SPEC;
+    
+    synthetic_backend_t *synth = calloc(1, sizeof(*synth));
+    if (!synth) {
+        fprintf(stderr, "Out of memory opening %s\n", device);
+        return -1;
+    }
+    if (parse_spec(synth, spec) < 0) {
+        fprintf(stderr, "Invalid synthetic signal spec: %s\n", spec);
+        free(synth);
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, &synth->start);
+    
+    if (backend->verbose) {
+        printf("Synthetic signals: %s\n", spec);
+    }
+    backend->priv = synth;
+    return 0;
+}
+
+static int synthetic_read_state(capture_backend_t *backend, signal_state_t *state,
+                                struct timespec *ts) {
+    synthetic_backend_t *synth = backend->priv;
+    long long t;
+    
+    if (synth->step_ns) {
+        // Virtual clock: every sample is exactly one step after the previous
+        t = synth->samples++ * synth->step_ns;
+        long long ns = synth->start.tv_nsec + t;
+        ts->tv_sec = synth->start.tv_sec + (time_t)(ns / 1000000000LL);
+        ts->tv_nsec = (long)(ns % 1000000000LL);
+    } else {
+        clock_gettime(CLOCK_REALTIME, ts);
+        t = elapsed_ns(&synth->start, ts);
+    }
+    
+    state->cts = signal_level(synth, SIGNAL_CTS, t);
+    state->rts = signal_level(synth, SIGNAL_RTS, t);
+    state->dsr = signal_level(synth, SIGNAL_DSR, t);
+    state->dtr = signal_level(synth, SIGNAL_DTR, t);
+    return 0;
+}
+
+// Sleep until the next generated edge
+static int synthetic_wait_edge(capture_backend_t *backend, int timeout_ms) {
+    const synthetic_backend_t *synth = backend->priv;
+    struct timespec now;
+    long long wait_ns = timeout_ms * 1000000LL;
+    int edge = 0;
+    
+    // The virtual clock advances per sample, so there is nothing to wait for
+    if (synth->step_ns) {
+        return 1;
+    }
+    
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long t = elapsed_ns(&synth->start, &now);
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        long long next = next_change(synth, i, t);
+        if (next >= 0 && next - t <= wait_ns) {
+            wait_ns = next - t;
+            edge = 1;
+        }
+    }
+    
+    struct timespec delay = { (time_t)(wait_ns / 1000000000LL), (long)(wait_ns % 1000000000LL) };
+    if (nanosleep(&delay, NULL) < 0 && errno == EINTR) {
+        return 0;
+    }
+    return edge;
+}
+
+// Time of the latest sample, as ns since the start
+static long long current_time(const synthetic_backend_t *synth, struct timespec *ts) {
+    if (!synth->step_ns) {
+        clock_gettime(CLOCK_REALTIME, ts);
+        return elapsed_ns(&synth->start, ts);
+    }
+    
+    long long t = (synth->samples > 0 ? synth->samples - 1 : 0) * synth->step_ns;
+    long long ns = synth->start.tv_nsec + t;
+    ts->tv_sec = synth->start.tv_sec + (time_t)(ns / 1000000000LL);
+    ts->tv_nsec = (long)(ns % 1000000000LL);
+    return t;
+}
+
+// Written lines switch from their pattern to the driven level
+static int synthetic_set_lines(capture_backend_t *backend, int set_mask, int clear_mask,
+                               struct timespec *ts) {
+    synthetic_backend_t *synth = backend->priv;
+    long long t = current_time(synth, ts);
+    
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        synth_signal_t *sig = &synth->signals[i];
+        if (!((set_mask | clear_mask) & (1 << i))) {
+            continue;
+        }
+        if (i != SIGNAL_RTS && i != SIGNAL_DTR) {
+            fprintf(stderr, "Synthetic backend can only drive RTS and DTR\n");
+            return -1;
+        }
+        sig->previous = signal_level(synth, i, t);
+        sig->kind = SYNTH_DRIVEN;
+        sig->level = (set_mask & (1 << i)) != 0;
+        sig->written = t;
+    }
+    return 0;
+}
+
+static void synthetic_close(capture_backend_t *backend) {
+    free(backend->priv);
+    backend->priv = NULL;
+}
+
+const capture_backend_ops_t synthetic_backend_ops = {
+    .name = "synthetic",
+    .open = synthetic_open,
+    .read_state = synthetic_read_state,
+    .wait_edge = synthetic_wait_edge,
+    .set_lines = synthetic_set_lines,
+    .close = synthetic_close
+};
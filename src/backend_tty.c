@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <errno.h>
+#include "capture_backend.h"
+#include "signal_state.h"
+
+typedef struct {
+    int fd;     /**< Serial port, opened non-blocking */
+} tty_backend_t;
+
+static int tty_open(capture_backend_t *backend, const monitor_config_t *config) {
+    const char *device = config->serial_device;
+    tty_backend_t *tty = malloc(sizeof(*tty));
+    if (!tty) {
+        fprintf(stderr, "Out of memory opening %s\n", device);
+        return -1;
+    }
+
+    // Non-blocking so select() wakeups can be drained without stalling
+    tty->fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (tty->fd < 0) {
+        fprintf(stderr, "Error opening serial device %s: %s\n", device, strerror(errno));
+        free(tty);
+        return -1;
+    }
+
+    // Configure serial port (minimal configuration, just for control signals)
+    struct termios attr;
+    if (tcgetattr(tty->fd, &attr) < 0) {
+        fprintf(stderr, "Error getting serial port attributes: %s\n", strerror(errno));
+        close(tty->fd);
+        free(tty);
+        return -1;
+    }
+
+    cfmakeraw(&attr);
+    attr.c_cflag |= CLOCAL;     // Ignore modem control lines
+    attr.c_cflag &= ~CRTSCTS;   // Disable hardware flow control initially
+
+    if (tcsetattr(tty->fd, TCSANOW, &attr) < 0) {
+        fprintf(stderr, "Error setting serial port attributes: %s\n", strerror(errno));
+        close(tty->fd);
+        free(tty);
+        return -1;
+    }
+
+    backend->priv = tty;
+    return 0;
+}
+
+static int tty_read_state(capture_backend_t *backend, signal_state_t *state, struct timespec *ts) {
+    tty_backend_t *tty = backend->priv;
+    int status;
+
+    if (ioctl(tty->fd, TIOCMGET, &status) < 0) {
+        if (backend->verbose) {
+            fprintf(stderr, "Error reading serial port status: %s\n", strerror(errno));
+        }
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, ts);
+
+    signal_state_decode(status, state);
+    return 0;
+}
+
+static int tty_wait_edge(capture_backend_t *backend, int timeout_ms) {
+    tty_backend_t *tty = backend->priv;
+    fd_set readfds, errorfds;
+    struct timeval timeout;
+
+    FD_ZERO(&readfds);
+    FD_ZERO(&errorfds);
+    FD_SET(tty->fd, &readfds);
+    FD_SET(tty->fd, &errorfds);
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    int result = select(tty->fd + 1, &readfds, NULL, &errorfds, &timeout);
+    if (result < 0) {
+        if (errno != EINTR) {   // Ignore interruption by signals
+            fprintf(stderr, "select() failed: %s\n", strerror(errno));
+            return -1;
+        }
+        return 0;
+    }
+
+    if (result > 0) {
+        // Read and discard pending data - only control signal changes matter
+        char buffer[256];
+        while (read(tty->fd, buffer, sizeof(buffer)) > 0) {
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static int tty_set_lines(capture_backend_t *backend, int set_mask, int clear_mask,
+                         struct timespec *ts) {
+    tty_backend_t *tty = backend->priv;
+    int set = signal_state_encode(set_mask);
+    int clear = signal_state_encode(clear_mask);
+
+    if ((set && ioctl(tty->fd, TIOCMBIS, &set) < 0) ||
+        (clear && ioctl(tty->fd, TIOCMBIC, &clear) < 0)) {
+        fprintf(stderr, "Error driving serial port lines: %s\n", strerror(errno));
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, ts);
+    return 0;
+}
+
+static void tty_close(capture_backend_t *backend) {
+    tty_backend_t *tty = backend->priv;
+    if (tty) {
+        close(tty->fd);
+        free(tty);
+        backend->priv = NULL;
+    }
+}
+
+const capture_backend_ops_t tty_backend_ops = {
+    .name = "serial",
+    .open = tty_open,
+    .read_state = tty_read_state,
+    .wait_edge = tty_wait_edge,
+    .set_lines = tty_set_lines,
+    .close = tty_close
+};
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <string.h>
+#include "capture_backend.h"
+
+int capture_backend_open(capture_backend_t *backend, const monitor_config_t *config) {
+    const char *device = config->serial_device;
+
+    memset(backend, 0, sizeof(*backend));
+    backend->verbose = config->verbose;
+
+    if (strncmp(device, "synthetic", 9) == 0 && (device[9] == '\0' || device[9] == ':')) {
+        backend->ops = &synthetic_backend_ops;
+        return backend->ops->open(backend, config);
+    }
+
+    if (strncmp(device, "replay:", 7) == 0) {
+        backend->ops = &replay_backend_ops;
+        return backend->ops->open(backend, config);
+    }
+
+#ifdef HAVE_LIBFTDI1
+    if (ftdi_backend_probe(device) == 1) {
+        if (config->verbose) {
+            printf("FTDI device detected - attempting direct GPIO monitoring\n");
+        }
+        backend->ops = &ftdi_backend_ops;
+        if (backend->ops->open(backend, config) == 0) {
+            return 0;
+        }
+        if (config->verbose) {
+            printf("FTDI initialization failed, falling back to standard serial interface\n");
+        }
+    }
+#endif
+
+    backend->ops = &tty_backend_ops;
+    return backend->ops->open(backend, config);
+}
+
+void capture_backend_close(capture_backend_t *backend) {
+    if (backend->ops) {
+        backend->ops->close(backend);
+        backend->ops = NULL;
+    }
+}
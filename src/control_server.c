@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include "control_server.h"
+#include "timestamp.h"
+#include "unix_socket.h"
+
+// Connections idle for this long are closed to free their slot
+#define CONTROL_IDLE_TIMEOUT_NS 60000000000LL
+
+int control_server_open(control_server_t *server, const char *path) {
+    memset(server, 0, sizeof(*server));
+    server->path = path;
+    for (int i = 0; i < CONTROL_SERVER_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+    }
+
+    server->listen_fd = unix_socket_listen(path, CONTROL_SERVER_MAX_CLIENTS, "control");
+    return server->listen_fd < 0 ? -1 : 0;
+}
+
+static void close_client(control_client_t *client) {
+    close(client->fd);
+    client->fd = -1;
+    client->line_len = 0;
+}
+
+// Replies are short; a client that cannot take one is dropped
+static int send_reply(control_client_t *client, const char *reply) {
+    char line[CONTROL_SERVER_LINE_MAX + 1];
+    int len = snprintf(line, sizeof(line), "%s\n", reply);
+    if (len >= (int)sizeof(line)) {
+        len = (int)sizeof(line) - 1;
+        line[len - 1] = '\n';
+    }
+    if (send(client->fd, line, (size_t)len, MSG_DONTWAIT | MSG_NOSIGNAL) != len) {
+        close_client(client);
+        return -1;
+    }
+    return 0;
+}
+
+// Run every complete line in the buffer and keep the incomplete rest
+static void run_commands(control_client_t *client, control_handler_t handler, void *context) {
+    char reply[CONTROL_SERVER_LINE_MAX];
+    char *start = client->line;
+    char *end;
+
+    while ((end = memchr(start, '\n', client->line_len - (size_t)(start - client->line))) != NULL) {
+        *end = '\0';
+        if (end > start && end[-1] == '\r') {
+            end[-1] = '\0';
+        }
+        if (*start) {
+            reply[0] = '\0';
+            handler(context, start, reply, sizeof(reply));
+            if (send_reply(client, reply) < 0) {
+                return;
+            }
+        }
+        start = end + 1;
+    }
+
+    client->line_len -= (size_t)(start - client->line);
+    memmove(client->line, start, client->line_len);
+    if (client->line_len == sizeof(client->line)) {
+        send_reply(client, "error command too long");
+        if (client->fd >= 0) {
+            close_client(client);
+        }
+    }
+}
+
+void control_server_service(control_server_t *server, control_handler_t handler, void *context,
+                            const struct timespec *now) {
+    int fd;
+
+    while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        control_client_t *client = NULL;
+        for (int i = 0; i < CONTROL_SERVER_MAX_CLIENTS && !client; i++) {
+            if (server->clients[i].fd < 0) {
+                client = &server->clients[i];
+            }
+        }
+        if (!client) {
+            close(fd);
+            continue;
+        }
+        client->fd = fd;
+        client->line_len = 0;
+        client->active = *now;
+    }
+
+    for (int i = 0; i < CONTROL_SERVER_MAX_CLIENTS; i++) {
+        control_client_t *client = &server->clients[i];
+        int closed = 0;
+
+        while (client->fd >= 0 && client->line_len < sizeof(client->line)) {
+            ssize_t n = recv(client->fd, client->line + client->line_len,
+                             sizeof(client->line) - client->line_len, MSG_DONTWAIT);
+            if (n <= 0) {
+                closed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+                // A last command without a line end still runs once the client shuts down its side
+                if (n == 0 && client->line_len > 0) {
+                    client->line[client->line_len++] = '\n';
+                    run_commands(client, handler, context);
+                }
+                break;
+            }
+            client->line_len += (size_t)n;
+            client->active = *now;
+            run_commands(client, handler, context);
+        }
+
+        if (client->fd >= 0 && (closed || elapsed_ns(&client->active, now) > CONTROL_IDLE_TIMEOUT_NS)) {
+            close_client(client);
+        }
+    }
+}
+
+void control_server_close(control_server_t *server) {
+    for (int i = 0; i < CONTROL_SERVER_MAX_CLIENTS; i++) {
+        if (server->clients[i].fd >= 0) {
+            close_client(&server->clients[i]);
+        }
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        unlink(server->path);
+    }
+}
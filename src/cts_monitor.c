@@ -1,760 +1,1656 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
+#include <limits.h>
 #include <unistd.h>
-#include <fcntl.h>
-#include <termios.h>
-#include <sys/ioctl.h>
 #include <sys/time.h>
-#include <sys/select.h>
 #include <time.h>
 #include <errno.h>
 #include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
 #include "cts_monitor.h"
+#include "mmap_capture.h"
+#include "log_rotate.h"
+#include "pulse_stats.h"
+#include "hdr_histogram.h"
+#include "handshake.h"
+#include "glitch_filter.h"
+#include "trigger.h"
+#include "vcd_writer.h"
+#include "pcapng_writer.h"
+#include "stream_server.h"
+#include "shm_ring.h"
+#include "metrics.h"
+#include "capture_backend.h"
+#include "timestamp.h"
+#include "signal_state.h"
+#include "loopback.h"
+#include "output_queue.h"
+#include "control_server.h"
 
-#ifdef HAVE_LIBFTDI1
-#include <ftdi.h>
-#include <libusb-1.0/libusb.h>
-#endif
 
-static int initialized = 0;
-static int serial_fd = -1;
-static FILE *output_fp = NULL;
-static monitor_config_t current_config;
-static signal_state_t last_state;
-static struct timespec start_time;
-static int irq_mode_active = 0;
-static volatile int cleanup_in_progress = 0;
+// Size of a cache line; the monitor and its hot members start on one
+#define CACHE_LINE_SIZE 64
+#define CACHE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
 
-#ifdef HAVE_LIBFTDI1
-static struct ftdi_context ftdi_ctx;
-static int ftdi_initialized = 0;
-static int using_ftdi = 0;
-#endif
+struct cts_monitor {
+    // Read on every sample
+    capture_backend_t backend;
+    monitor_config_t config;
+    signal_state_t last_state;
+    int signal_mask;  // Signals that produce edges
+    struct timespec last_sample_time;
+    long long sample_window_ns;
+    struct timespec start_time;
+    int input_finished;
+    int irq_mode_active;
+    int mmap_active;
+    int rotate_active;
+    int handshake_active;
+    int glitch_active;
+    int trigger_active;
+    int stream_active;
+    int shm_active;
+    int metrics_active;
+    int loopback_active;
+    int control_active;
+    FILE *output_fp;
+    time_t last_flush_sec;
+    long long stream_service_slot;
+    long long metrics_service_slot;
+    long long control_service_slot;
+    cts_monitor_edge_callback_t edge_callback;
+    void *edge_callback_data;
+    size_t edge_batch_size;
+    size_t edge_batch_count;
+    struct timespec edge_batch_time;  // Time of the oldest queued edge
+    uint32_t edge_sequence;
+    int output_thread_active;
+    
+    // Written on every edge
+    monitor_metrics_t metrics CACHE_ALIGNED;
+    cts_edge_event_t edge_batch[CTS_MONITOR_MAX_BATCH] CACHE_ALIGNED;
+    glitch_filter_t glitch_filter CACHE_ALIGNED;
+    trigger_t trigger;
+    vcd_writer_t vcd;
+    mmap_capture_t mmap_out;
+    log_rotate_t rotate_out;
+    shm_ring_writer_t shm_ring;
+    pulse_stats_t pulse_stats;
+    handshake_t handshake;
+    loopback_t loopback;
+    
+    // Owned by the output thread while it runs
+    output_queue_t output_queue CACHE_ALIGNED;
+    signal_state_t output_state;  // Levels as last written to the output
+    pthread_t output_thread;
+    pthread_mutex_t output_lock;  // Guards the output metrics against scrapes
+    int output_stop;
+    
+    // Serviced every 10 ms or read for reports
+    stream_server_t stream_server CACHE_ALIGNED;
+    metrics_server_t metrics_server;
+    control_server_t control_server;
+    char output_path[PATH_MAX];  // Output file set by reconfiguration
+    hdr_histogram_t width_hist[SIGNAL_COUNT][2];  // Indexed by signal and level
+    hdr_histogram_t detect_window_hist;  // Gap between the previous and the detecting sample
+    hdr_histogram_t write_latency_hist;  // Detecting sample to edge record written
+};
 
-// Get high-precision timestamp
-static void get_timestamp(char *buffer, size_t size) {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+// Format a high-precision timestamp
+static void get_timestamp(cts_monitor_t *mon, const struct timespec *ts, char *buffer, size_t size) {
+    timestamp_format(ts, &mon->start_time, mon->config.time_format, buffer, size);
+}
+
+// Sample the signals through the capture backend; 1 once the input is exhausted
+static int read_signal_state(cts_monitor_t *mon, signal_state_t *state, struct timespec *ts) {
+    int ret = mon->backend.ops->read_state(&mon->backend, state, ts);
+    if (ret < 0) {
+        mon->metrics.read_errors.value++;
+    } else if (ret > 0) {
+        mon->input_finished = 1;
+    }
+    return ret;
+}
+
+// Maximum length of a single output record
+#define OUTPUT_RECORD_MAX 256
+
+// Open the configured output destination
+static int open_output(cts_monitor_t *mon) {
+    if (mon->config.output_backend == OUTPUT_BACKEND_NONE) {
+        return 0;
+    }
+    
+    if (mon->config.output_backend == OUTPUT_BACKEND_MMAP) {
+        if (!mon->config.output_file) {
+            fprintf(stderr, "The mmap output backend requires an output file (-o)\n");
+            return -1;
+        }
+        if (mmap_capture_open(&mon->mmap_out, mon->config.output_file,
+                              mon->config.segment_size,
+                              mon->config.rotate_interval) < 0) {
+            return -1;
+        }
+        mon->mmap_active = 1;
+        return 0;
+    }
+
+    if (mon->config.output_file &&
+        (mon->config.rotate_size > 0 || mon->config.rotate_interval > 0)) {
+        if (log_rotate_open(&mon->rotate_out, mon->config.output_file,
+                            mon->config.rotate_size,
+                            mon->config.rotate_interval) < 0) {
+            return -1;
+        }
+        mon->rotate_active = 1;
+        return 0;
+    }
+
+    if (mon->config.output_file) {
+        mon->output_fp = fopen(mon->config.output_file, "w");
+        if (!mon->output_fp) {
+            fprintf(stderr, "Error opening output file %s: %s\n", 
+                    mon->config.output_file, strerror(errno));
+            return -1;
+        }
+    } else {
+        mon->output_fp = stdout;
+    }
+    
+    return 0;
+}
+
+// Account written bytes; with an output thread, scrapes read them under the lock
+static void count_output(cts_monitor_t *mon, size_t len) {
+    if (mon->output_thread_active) {
+        pthread_mutex_lock(&mon->output_lock);
+        mon->metrics.bytes_written.value += len;
+        pthread_mutex_unlock(&mon->output_lock);
+    } else {
+        mon->metrics.bytes_written.value += len;
+    }
+}
+
+// Close the output destination
+static void close_output(cts_monitor_t *mon) {
+    if (mon->mmap_active) {
+        mmap_capture_close(&mon->mmap_out);
+        mon->mmap_active = 0;
+    }
+    
+    if (mon->rotate_active) {
+        log_rotate_close(&mon->rotate_out);
+        mon->rotate_active = 0;
+    }
     
-    if (current_config.time_format == TIME_FORMAT_ABSOLUTE) {
-        // Absolute time with microsecond precision
-        struct tm *tm_info = localtime(&ts.tv_sec);
-        size_t len = strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm_info);
-        snprintf(buffer + len, size - len, ".%06ld", ts.tv_nsec / 1000);
+    if (mon->output_fp && mon->output_fp != stdout) {
+        fclose(mon->output_fp);
+    }
+    mon->output_fp = NULL;
+}
+
+// Write a formatted record to the output destination as is
+static void output_vprintf(cts_monitor_t *mon, const struct timespec *ts, int is_edge,
+                           const char *format, va_list args) {
+    if (mon->mmap_active) {
+        // Format straight into the mapping, no intermediate copy
+        char *record = mmap_capture_reserve(&mon->mmap_out, OUTPUT_RECORD_MAX, ts);
+        if (record) {
+            int len = vsnprintf(record, OUTPUT_RECORD_MAX, format, args);
+            if (len >= OUTPUT_RECORD_MAX) {
+                len = OUTPUT_RECORD_MAX - 1;
+            }
+            if (len > 0) {
+                mmap_capture_commit(&mon->mmap_out, (size_t)len, is_edge);
+                count_output(mon, (size_t)len);
+            }
+        }
+    } else if (mon->rotate_active) {
+        FILE *fp = log_rotate_begin(&mon->rotate_out, ts);
+        if (fp) {
+            int len = vfprintf(fp, format, args);
+            if (len > 0) {
+                log_rotate_end(&mon->rotate_out, (size_t)len, is_edge);
+                count_output(mon, (size_t)len);
+            }
+        }
+    } else if (mon->output_fp) {
+        int len = vfprintf(mon->output_fp, format, args);
+        if (len > 0) {
+            count_output(mon, (size_t)len);
+        }
+    }
+}
+
+// Write a binary record to the output destination
+static void output_bytes(cts_monitor_t *mon, const struct timespec *ts, int is_edge,
+                         const void *data, size_t len) {
+    if (mon->mmap_active) {
+        char *record = mmap_capture_reserve(&mon->mmap_out, len, ts);
+        if (record) {
+            memcpy(record, data, len);
+            mmap_capture_commit(&mon->mmap_out, len, is_edge);
+            count_output(mon, len);
+        }
+    } else if (mon->rotate_active) {
+        FILE *fp = log_rotate_begin(&mon->rotate_out, ts);
+        if (fp && fwrite(data, len, 1, fp) == 1) {
+            log_rotate_end(&mon->rotate_out, len, is_edge);
+            count_output(mon, len);
+        }
+    } else if (mon->output_fp && fwrite(data, len, 1, mon->output_fp) == 1) {
+        count_output(mon, len);
+    }
+}
+
+static void output_write(cts_monitor_t *mon, const struct timespec *ts, int is_edge,
+                         const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    output_vprintf(mon, ts, is_edge, format, args);
+    va_end(args);
+}
+
+// Write a formatted record; in VCD and PCAP-NG output, text records become comments
+static void output_printf(cts_monitor_t *mon, const struct timespec *ts, int is_edge,
+                          const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    
+    if (mon->config.output_format != OUTPUT_FORMAT_TEXT && !is_edge) {
+        char text[OUTPUT_RECORD_MAX];
+        vsnprintf(text, sizeof(text), format, args);
+        text[strcspn(text, "\n")] = '\0';
+        if (mon->config.output_format == OUTPUT_FORMAT_VCD) {
+            output_write(mon, ts, 0, "$comment %s $end\n", text);
+        } else {
+            unsigned char block[OUTPUT_RECORD_MAX + 64];
+            size_t len = pcapng_format_comment(block, sizeof(block), 0, ts, text);
+            output_bytes(mon, ts, 0, block, len);
+        }
     } else {
-        // Relative time from start in microseconds
-        struct timespec diff;
-        diff.tv_sec = ts.tv_sec - start_time.tv_sec;
-        diff.tv_nsec = ts.tv_nsec - start_time.tv_nsec;
+        output_vprintf(mon, ts, is_edge, format, args);
+    }
+    
+    va_end(args);
+}
+
+// Push buffered output to the destination
+static void output_flush(cts_monitor_t *mon) {
+    if (mon->rotate_active && mon->rotate_out.fp) {
+        fflush(mon->rotate_out.fp);
+    } else if (mon->output_fp) {
+        fflush(mon->output_fp);
+    }
+}
+
+// Write the format header at the start of an output file
+static void write_output_header(cts_monitor_t *mon, const struct timespec *start,
+                                const signal_state_t *state) {
+    char line[128];
+    
+    if (mon->config.output_format == OUTPUT_FORMAT_VCD) {
+        vcd_writer_init(&mon->vcd, start);
+        for (int i = 0; vcd_format_header(&mon->vcd, line, sizeof(line), i,
+                                          mon->signal_mask, state) > 0; i++) {
+            output_write(mon, start, 0, "%s", line);
+        }
+        output_flush(mon);
+    } else if (mon->config.output_format == OUTPUT_FORMAT_PCAPNG) {
+        unsigned char blocks[2 * OUTPUT_RECORD_MAX + PATH_MAX];
+        size_t len = pcapng_format_header(blocks, sizeof(blocks), mon->config.serial_device);
+        output_bytes(mon, start, 0, blocks, len);
+        output_flush(mon);
+        mon->last_flush_sec = start->tv_sec;
+    }
+}
+
+// Continue in a new plain output stream; runs where the records are written
+static void install_output(cts_monitor_t *mon, FILE *fp) {
+    struct timespec now;
+    
+    if (mon->output_fp && mon->output_fp != stdout) {
+        fclose(mon->output_fp);
+    }
+    mon->output_fp = fp;
+    
+    // A fresh VCD or PCAP-NG file needs its own header
+    if (fp != stdout && ftell(fp) == 0) {
+        clock_gettime(CLOCK_REALTIME, &now);
+        write_output_header(mon, &now, &mon->output_state);
+    }
+}
+
+// Move plain stdio output to a file opened for appending, or to stdout if
+// path is NULL; records already queued for the output thread still go to
+// the old file
+static int switch_output(cts_monitor_t *mon, const char *path, char *error, size_t size) {
+    FILE *fp = stdout;
+    
+    if (path) {
+        fp = fopen(path, "a");
+        if (!fp) {
+            snprintf(error, size, "cannot open %s: %s", path, strerror(errno));
+            return -1;
+        }
+    }
+    
+    if (!mon->output_thread_active) {
+        install_output(mon, fp);
+        return 0;
+    }
+    
+    output_queue_record_t *record = output_queue_reserve(&mon->output_queue);
+    if (!record) {
+        if (fp != stdout) {
+            fclose(fp);
+        }
+        snprintf(error, size, "output queue full, try again");
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, &record->ts);
+    record->kind = OUTPUT_QUEUE_SWITCH;
+    record->stream = fp;
+    output_queue_commit(&mon->output_queue);
+    return 0;
+}
+
+// Whether the output is a single stdio stream that can be switched
+static int output_switchable(const cts_monitor_t *mon) {
+    return mon->config.output_backend == OUTPUT_BACKEND_STDIO && !mon->rotate_active;
+}
+
+void cts_monitor_get_settings(const cts_monitor_t *mon, cts_monitor_settings_t *settings) {
+    settings->poll_interval_us = mon->config.poll_interval_us;
+    settings->signal_mask = mon->signal_mask;
+    settings->output_file = mon->config.output_file;
+}
+
+// Check all settings, then apply them together; the reason for a rejection goes to error
+static int apply_settings(cts_monitor_t *mon, const cts_monitor_settings_t *settings,
+                          char *error, size_t size) {
+    const int handshake_mask = (1 << SIGNAL_CTS) | (1 << SIGNAL_RTS);
+    const char *path = settings->output_file;
+    const char *current = mon->config.output_file;
+    int changed_signals = settings->signal_mask ^ mon->signal_mask;
+    int new_output = (path == NULL) != (current == NULL) || (path && strcmp(path, current) != 0);
+    
+    if (settings->poll_interval_us < CTS_MONITOR_MIN_POLL_INTERVAL_US) {
+        snprintf(error, size, "minimum polling interval is %d microseconds",
+                 CTS_MONITOR_MIN_POLL_INTERVAL_US);
+        return -1;
+    }
+    if (settings->signal_mask <= 0 || settings->signal_mask >= (1 << SIGNAL_COUNT)) {
+        snprintf(error, size, "invalid signal set");
+        return -1;
+    }
+    if (changed_signals && mon->config.output_format == OUTPUT_FORMAT_VCD) {
+        snprintf(error, size, "the VCD header fixes the signal set");
+        return -1;
+    }
+    if (mon->config.handshake && (settings->signal_mask & handshake_mask) != handshake_mask) {
+        snprintf(error, size, "handshake analysis needs CTS and RTS");
+        return -1;
+    }
+    if (new_output && !output_switchable(mon)) {
+        snprintf(error, size, "only unsegmented stdio output can change its file");
+        return -1;
+    }
+    if (path && strlen(path) >= sizeof(mon->output_path)) {
+        snprintf(error, size, "output path too long");
+        return -1;
+    }
+    
+    // Opening the file is the last step that can fail
+    if (new_output && switch_output(mon, path, error, size) < 0) {
+        return -1;
+    }
+    
+    if (new_output) {
+        if (path && path != mon->output_path) {
+            strcpy(mon->output_path, path);
+        }
+        mon->config.output_file = path ? mon->output_path : NULL;
+    }
+    mon->config.poll_interval_us = settings->poll_interval_us;
+    
+    // Signals joining or leaving the set restart at their current level,
+    // so the time they were not monitored never counts as a pulse
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (changed_signals & (1 << i)) {
+            int level = signal_state_level(&mon->last_state, (signal_id_t)i);
+            if (mon->glitch_active) {
+                glitch_filter_restart(&mon->glitch_filter, (signal_id_t)i, level);
+            }
+            pulse_stats_restart(&mon->pulse_stats, (signal_id_t)i);
+        }
+    }
+    if (mon->handshake_active && (changed_signals & handshake_mask)) {
+        handshake_cancel(&mon->handshake);
+    }
+    mon->signal_mask = settings->signal_mask;
+    return 0;
+}
+
+// Run one control socket command: get, set KEY=VALUE..., reopen
+static void handle_control(void *context, char *command, char *reply, size_t size) {
+    cts_monitor_t *mon = context;
+    cts_monitor_settings_t settings;
+    char error[CONTROL_SERVER_LINE_MAX];
+    char signals[32];
+    char *save;
+    char *verb = strtok_r(command, " \t", &save);
+    
+    cts_monitor_get_settings(mon, &settings);
+    
+    if (verb && strcmp(verb, "get") == 0) {
+        signal_state_format_mask(settings.signal_mask, signals, sizeof(signals));
+        snprintf(reply, size, "ok interval=%d signals=%s output=%s", settings.poll_interval_us,
+                 signals, settings.output_file ? settings.output_file : "-");
+    } else if (verb && strcmp(verb, "set") == 0) {
+        // Collect every setting of the line first; they take effect together
+        for (char *token = strtok_r(NULL, " \t", &save); token; token = strtok_r(NULL, " \t", &save)) {
+            char *value = strchr(token, '=');
+            if (!value) {
+                snprintf(reply, size, "error expected KEY=VALUE, got %s", token);
+                return;
+            }
+            *value++ = '\0';
+            
+            if (strcmp(token, "interval") == 0) {
+                char *end;
+                long us = strtol(value, &end, 10);
+                if (end == value || *end != '\0' || us > 1000000000L) {
+                    snprintf(reply, size, "error invalid interval %s", value);
+                    return;
+                }
+                settings.poll_interval_us = (int)us;
+            } else if (strcmp(token, "signals") == 0) {
+                settings.signal_mask = signal_state_parse_mask(value);
+                if (settings.signal_mask < 0) {
+                    snprintf(reply, size, "error invalid signal list %s", value);
+                    return;
+                }
+            } else if (strcmp(token, "output") == 0) {
+                settings.output_file = strcmp(value, "-") == 0 ? NULL : value;
+            } else {
+                snprintf(reply, size, "error unknown setting %s (interval, signals, output)", token);
+                return;
+            }
+        }
+        if (apply_settings(mon, &settings, error, sizeof(error)) < 0) {
+            snprintf(reply, size, "error %s", error);
+        } else {
+            snprintf(reply, size, "ok");
+        }
+    } else if (verb && strcmp(verb, "reopen") == 0) {
+        if (output_switchable(mon) && settings.output_file &&
+            switch_output(mon, settings.output_file, error, sizeof(error)) < 0) {
+            snprintf(reply, size, "error %s", error);
+        } else {
+            snprintf(reply, size, "ok");
+        }
+    } else {
+        snprintf(reply, size, "error unknown command %s (get, set, reopen)", verb ? verb : "");
+    }
+}
+
+// Feed pulse widths into the histograms
+static void record_histograms(cts_monitor_t *mon, signal_id_t signal, int new_state, long long duration) {
+    // The phase that just ended had the opposite level
+    if (duration >= 0) {
+        hdr_histogram_record(&mon->width_hist[signal][!new_state], (uint64_t)duration);
+    }
+}
+
+// Print histogram percentile tables
+static void print_histograms(cts_monitor_t *mon, FILE *fp) {
+    char name[32];
+    
+    fprintf(fp, "=== Histograms (microseconds) ===\n");
+    hdr_histogram_print_header(fp);
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        snprintf(name, sizeof(name), "%s.high", signal_names[i]);
+        hdr_histogram_print(&mon->width_hist[i][1], name, fp);
+        snprintf(name, sizeof(name), "%s.low", signal_names[i]);
+        hdr_histogram_print(&mon->width_hist[i][0], name, fp);
+    }
+    hdr_histogram_print(&mon->handshake.channels[HANDSHAKE_ASSERT].latency, "RTS->CTS", fp);
+    hdr_histogram_print(&mon->handshake.channels[HANDSHAKE_DEASSERT].latency, "RTS->CTS.release", fp);
+    fflush(fp);
+}
+
+// Print detection latency percentile tables
+static void print_latency(cts_monitor_t *mon, FILE *fp) {
+    fprintf(fp, "=== Detection Latency (microseconds) ===\n");
+    hdr_histogram_print_header(fp);
+    hdr_histogram_print(&mon->detect_window_hist, "detect.window", fp);
+    if (mon->output_thread_active) {
+        pthread_mutex_lock(&mon->output_lock);
+        hdr_histogram_print(&mon->write_latency_hist, "detect.write", fp);
+        pthread_mutex_unlock(&mon->output_lock);
+    } else {
+        hdr_histogram_print(&mon->write_latency_hist, "detect.write", fp);
+    }
+    fflush(fp);
+}
+
+// Monitor mode name for loopback reports
+static const char *mode_name(const cts_monitor_t *mon) {
+    return mon->config.mode == MONITOR_MODE_IRQ ? "irq" : "poll";
+}
+
+// Save all histograms as a mergeable binary blob
+static void write_histograms(cts_monitor_t *mon) {
+    char name[32];
+    int failed = 0;
+    
+    FILE *fp = fopen(mon->config.hist_file, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error opening histogram file %s: %s\n",
+                mon->config.hist_file, strerror(errno));
+        return;
+    }
+    
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        snprintf(name, sizeof(name), "%s.high", signal_names[i]);
+        failed |= hdr_histogram_write(fp, name, &mon->width_hist[i][1]);
+        snprintf(name, sizeof(name), "%s.low", signal_names[i]);
+        failed |= hdr_histogram_write(fp, name, &mon->width_hist[i][0]);
+    }
+    failed |= hdr_histogram_write(fp, "RTS->CTS", &mon->handshake.channels[HANDSHAKE_ASSERT].latency);
+    failed |= hdr_histogram_write(fp, "RTS->CTS.release",
+                                  &mon->handshake.channels[HANDSHAKE_DEASSERT].latency);
+    if (mon->config.latency) {
+        failed |= hdr_histogram_write(fp, "detect.window", &mon->detect_window_hist);
+        failed |= hdr_histogram_write(fp, "detect.write", &mon->write_latency_hist);
+    }
+    if (mon->loopback_active) {
+        for (int i = 0; i < LOOPBACK_PATHS; i++) {
+            loopback_path_name((loopback_path_t)i, mode_name(mon), name, sizeof(name));
+            failed |= hdr_histogram_write(fp, name, &mon->loopback.channels[i].latency);
+        }
+    }
+    
+    if (fclose(fp) != 0 || failed) {
+        fprintf(stderr, "Error writing histogram file %s\n", mon->config.hist_file);
+    }
+}
+
+// Hand the queued edges to the registered callback
+static void deliver_edges(cts_monitor_t *mon) {
+    if (mon->edge_batch_count > 0) {
+        mon->edge_callback(mon->edge_batch, mon->edge_batch_count, mon->edge_callback_data);
+        mon->edge_batch_count = 0;
+    }
+}
+
+// Queue an edge for the callback, delivering full batches
+static void queue_edge(cts_monitor_t *mon, signal_id_t signal, int new_state, const struct timespec *ts) {
+    cts_edge_event_t *event = &mon->edge_batch[mon->edge_batch_count];
+    
+    if (mon->edge_batch_count == 0) {
+        mon->edge_batch_time = *ts;
+    }
+    event->time_ns = (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+    event->sequence = mon->edge_sequence++;
+    event->signal = (uint8_t)signal;
+    event->level = (uint8_t)new_state;
+    event->reserved = 0;
+    
+    if (++mon->edge_batch_count == mon->edge_batch_size) {
+        deliver_edges(mon);
+    }
+}
+
+// Format and write an edge record
+static void format_edge(cts_monitor_t *mon, signal_id_t signal, int new_state,
+                        const struct timespec *ts) {
+    char timestamp[64];
+    get_timestamp(mon, ts, timestamp, sizeof(timestamp));
+    
+    const char *signal_name = signal_names[signal];
+    const char *state_str = new_state ? "HIGH" : "LOW";
+    const char *transition = new_state ? "↑" : "↓";
+    
+    if (mon->config.output_format == OUTPUT_FORMAT_VCD) {
+        char change[64];
+        vcd_format_change(&mon->vcd, change, sizeof(change), ts, signal, new_state);
+        output_write(mon, ts, 1, "%s", change);
+    } else if (mon->config.output_format == OUTPUT_FORMAT_PCAPNG) {
+        unsigned char block[64];
+        size_t len = pcapng_format_edge(block, sizeof(block), 0, ts, signal, new_state);
+        output_bytes(mon, ts, 1, block, len);
+    } else {
+        output_printf(mon, ts, 1, "[%s] %s: %s %s\n", timestamp, signal_name, state_str, transition);
+    }
+    
+    if (mon->config.verbose && mon->output_fp != stdout) {
+        printf("[%s] %s: %s %s\n", timestamp, signal_name, state_str, transition);
+    }
+    
+    signal_state_set(&mon->output_state, signal, new_state);
+    
+    if (mon->metrics_active) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        if (mon->output_thread_active) {
+            pthread_mutex_lock(&mon->output_lock);
+            metrics_output_lag(&mon->metrics, ts, &now);
+            pthread_mutex_unlock(&mon->output_lock);
+        } else {
+            metrics_output_lag(&mon->metrics, ts, &now);
+        }
+    }
+}
+
+// Record the time from the detecting sample until its edge record was written
+static void record_write_latency(cts_monitor_t *mon, const struct timespec *ts) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long written_ns = elapsed_ns(ts, &now);
+    if (written_ns < 0) {
+        return;
+    }
+    
+    if (mon->output_thread_active) {
+        pthread_mutex_lock(&mon->output_lock);
+        hdr_histogram_record(&mon->write_latency_hist, (uint64_t)written_ns);
+        pthread_mutex_unlock(&mon->output_lock);
+    } else {
+        hdr_histogram_record(&mon->write_latency_hist, (uint64_t)written_ns);
+    }
+}
+
+// Write an edge record, or hand it to the output thread
+static void write_edge(cts_monitor_t *mon, signal_id_t signal, int new_state,
+                       const struct timespec *ts, int timed) {
+    if (!mon->output_thread_active) {
+        format_edge(mon, signal, new_state, ts);
+        return;
+    }
+    
+    output_queue_record_t *record = output_queue_reserve(&mon->output_queue);
+    if (record) {
+        record->ts = *ts;
+        record->kind = OUTPUT_QUEUE_EDGE;
+        record->signal = (uint8_t)signal;
+        record->level = (uint8_t)new_state;
+        record->timed = (uint8_t)timed;
+        output_queue_commit(&mon->output_queue);
+    }
+}
+
+// Write a report line from the sampling path, through the output thread if there is one
+static void write_report(cts_monitor_t *mon, const struct timespec *ts, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    
+    if (!mon->output_thread_active) {
+        char text[OUTPUT_RECORD_MAX];
+        vsnprintf(text, sizeof(text), format, args);
+        output_printf(mon, ts, 0, "%s", text);
+    } else {
+        output_queue_record_t *record = output_queue_reserve(&mon->output_queue);
+        if (record) {
+            record->ts = *ts;
+            record->kind = OUTPUT_QUEUE_TEXT;
+            vsnprintf(record->text, sizeof(record->text), format, args);
+            output_queue_commit(&mon->output_queue);
+        }
+    }
+    
+    va_end(args);
+}
+
+// Push records written from the sampling path; the output thread flushes its own
+static void commit_output(cts_monitor_t *mon) {
+    if (!mon->output_thread_active) {
+        output_flush(mon);
+    }
+}
+
+// Write the trigger marker followed by the buffered pre-trigger edges
+static void dump_trigger(cts_monitor_t *mon) {
+    char timestamp[64];
+    trigger_event_t event;
+    
+    get_timestamp(mon, &mon->trigger.fire_time, timestamp, sizeof(timestamp));
+    write_report(mon, &mon->trigger.fire_time, "[%s] TRIGGER: %s fired (#%llu)\n",
+                 timestamp, mon->config.trigger, mon->trigger.fired);
+    
+    while (trigger_pop(&mon->trigger, &event)) {
+        write_edge(mon, (signal_id_t)event.signal, event.state, &event.ts, 0);
+    }
+    commit_output(mon);
+}
+
+// Log signal change
+static void log_signal_change(cts_monitor_t *mon, signal_id_t signal, int old_state, int new_state,
+                              const struct timespec *ts) {
+    (void)old_state;
+    
+    mon->metrics.edges[signal].value++;
+    
+    if (mon->shm_active) {
+        shm_ring_publish(&mon->shm_ring, ts, signal, new_state);
+    }
+    
+    if (mon->stream_active) {
+        char timestamp[64];
+        char line[128];
+        get_timestamp(mon, ts, timestamp, sizeof(timestamp));
+        int len = snprintf(line, sizeof(line), "[%s] %s: %s %s\n", timestamp, signal_names[signal],
+                           new_state ? "HIGH" : "LOW", new_state ? "↑" : "↓");
+        stream_server_publish(&mon->stream_server, ts, signal, new_state, line, (size_t)len);
+    }
+    
+    if (mon->edge_callback) {
+        queue_edge(mon, signal, new_state, ts);
+    }
+    
+    if (mon->config.stats || mon->config.hist_file) {
+        long long duration = pulse_stats_edge(&mon->pulse_stats, signal, new_state, ts);
+        if (mon->config.hist_file) {
+            record_histograms(mon, signal, new_state, duration);
+        }
+    }
+    
+    // Histograms alone pair RTS and CTS only while both are monitored
+    if (mon->handshake_active &&
+        (mon->config.handshake || (~mon->signal_mask & ((1 << SIGNAL_CTS) | (1 << SIGNAL_RTS))) == 0)) {
+        handshake_edge(&mon->handshake, signal, new_state, ts);
+    }
+    
+    if (mon->trigger_active) {
+        // While armed, edges only go into the pre-trigger buffer
+        if (!trigger_capturing(&mon->trigger, ts)) {
+            if (trigger_edge(&mon->trigger, signal, new_state, ts)) {
+                dump_trigger(mon);
+            }
+            return;
+        }
+        trigger_track(&mon->trigger, signal, new_state, ts);
+    }
+    
+    // Edges held back by the glitch filter carry an older sample time and are skipped
+    int timed = mon->config.latency && ts->tv_sec == mon->last_sample_time.tv_sec &&
+                ts->tv_nsec == mon->last_sample_time.tv_nsec;
+    
+    if (mon->config.output_backend != OUTPUT_BACKEND_NONE) {
+        write_edge(mon, signal, new_state, ts, timed);
         
-        if (diff.tv_nsec < 0) {
-            diff.tv_sec--;
-            diff.tv_nsec += 1000000000L;
+        // Binary captures are flushed in blocks once per second instead
+        if (mon->config.output_format != OUTPUT_FORMAT_PCAPNG) {
+            commit_output(mon);
+        }
+    }
+    
+    if (timed) {
+        if (mon->sample_window_ns >= 0) {
+            hdr_histogram_record(&mon->detect_window_hist, (uint64_t)mon->sample_window_ns);
+        }
+        // A queued edge is timed by the output thread once it is actually written
+        if (!mon->output_thread_active || mon->config.output_backend == OUTPUT_BACKEND_NONE) {
+            record_write_latency(mon, ts);
+        }
+    }
+}
+
+// Print a handshake latency summary line for one direction
+static int format_handshake_summary(char *buffer, size_t size, const char *label,
+                                    const handshake_channel_t *ch) {
+    const hdr_histogram_t *hist = &ch->minute_latency;
+    
+    return snprintf(buffer, size, "%s n=%llu p50=%.3f p99=%.3f max=%.3f timeouts=%lu",
+                    label, (unsigned long long)hist->total,
+                    hdr_histogram_percentile(hist, 50.0) / 1000.0,
+                    hdr_histogram_percentile(hist, 99.0) / 1000.0,
+                    hist->max / 1000.0, ch->minute_timeouts);
+}
+
+// Flag handshake timeouts and emit per-minute latency reports
+static void report_handshake(cts_monitor_t *mon, const struct timespec *ts) {
+    char timestamp[64];
+    handshake_direction_t direction;
+    struct timespec minute_start;
+    
+    while (handshake_check_timeout(&mon->handshake, ts, &direction)) {
+        get_timestamp(mon, ts, timestamp, sizeof(timestamp));
+        write_report(mon, ts, "[%s] HANDSHAKE: TIMEOUT %s no %s within %ld us\n",
+                     timestamp,
+                     direction == HANDSHAKE_ASSERT ? "RTS↑" : "RTS↓",
+                     direction == HANDSHAKE_ASSERT ? "CTS↑" : "CTS↓",
+                     mon->config.handshake_timeout_us);
+        commit_output(mon);
+    }
+    
+    if (handshake_minute_due(&mon->handshake, ts, &minute_start)) {
+        char assert_summary[128];
+        char deassert_summary[128];
+        
+        format_handshake_summary(assert_summary, sizeof(assert_summary), "assert",
+                                 &mon->handshake.channels[HANDSHAKE_ASSERT]);
+        format_handshake_summary(deassert_summary, sizeof(deassert_summary), "release",
+                                 &mon->handshake.channels[HANDSHAKE_DEASSERT]);
+        // The first minute only covers the time since the start
+        if (minute_start.tv_sec < mon->start_time.tv_sec ||
+            (minute_start.tv_sec == mon->start_time.tv_sec && minute_start.tv_nsec < mon->start_time.tv_nsec)) {
+            minute_start = mon->start_time;
+        }
+        get_timestamp(mon, &minute_start, timestamp, sizeof(timestamp));
+        write_report(mon, ts, "[%s] HANDSHAKE: minute %s; %s (us)\n",
+                     timestamp, assert_summary, deassert_summary);
+        commit_output(mon);
+        handshake_minute_reset(&mon->handshake);
+    }
+}
+
+// Print whole-run handshake counters
+static void print_handshake_summary(cts_monitor_t *mon, FILE *fp) {
+    static const char *const labels[HANDSHAKE_DIRECTIONS] = { "RTS↑→CTS↑", "RTS↓→CTS↓" };
+    
+    fprintf(fp, "=== Handshake Summary ===\n");
+    for (int i = 0; i < HANDSHAKE_DIRECTIONS; i++) {
+        const handshake_channel_t *ch = &mon->handshake.channels[i];
+        fprintf(fp, "%s: pairs=%llu timeouts=%llu unanswered=%llu p50=%.3f us p99=%.3f us max=%.3f us\n",
+                labels[i], ch->pairs, ch->timeouts, ch->unanswered,
+                hdr_histogram_percentile(&ch->latency, 50.0) / 1000.0,
+                hdr_histogram_percentile(&ch->latency, 99.0) / 1000.0,
+                ch->latency.max / 1000.0);
+    }
+    fflush(fp);
+}
+
+// Release edges the glitch filter has confirmed, stamped with their original sample time
+static int release_filtered_edges(cts_monitor_t *mon, const struct timespec *ts) {
+    signal_id_t signal;
+    int new_state;
+    struct timespec edge_time;
+    int events_processed = 0;
+    
+    while (glitch_filter_next(&mon->glitch_filter, ts, &signal, &new_state, &edge_time)) {
+        log_signal_change(mon, signal, !new_state, new_state, &edge_time);
+        events_processed++;
+    }
+    return events_processed;
+}
+
+// Detect changes through the glitch filter
+static int detect_filtered_changes(cts_monitor_t *mon, const signal_state_t *current_state,
+                                   const struct timespec *ts) {
+    int events_processed = release_filtered_edges(mon, ts);
+    
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (mon->signal_mask & (1 << i)) {
+            glitch_filter_sample(&mon->glitch_filter, (signal_id_t)i,
+                                 signal_state_level(current_state, (signal_id_t)i), ts);
+        }
+    }
+    
+    return events_processed + release_filtered_edges(mon, ts);
+}
+
+// Toggle the loopback lines when the next pattern step is due
+static void drive_loopback(cts_monitor_t *mon, const struct timespec *ts) {
+    int set_mask, clear_mask;
+    struct timespec write_time;
+    
+    if (loopback_due(&mon->loopback, ts, &set_mask, &clear_mask)) {
+        if (mon->backend.ops->set_lines(&mon->backend, set_mask, clear_mask, &write_time) < 0) {
+            mon->input_finished = 1;
+            return;
+        }
+        loopback_written(&mon->loopback, set_mask, clear_mask, &write_time);
+    }
+    if (loopback_done(&mon->loopback, ts)) {
+        mon->input_finished = 1;
+    }
+}
+
+// Per-sample work that does not depend on an edge
+static void finish_sample(cts_monitor_t *mon, const struct timespec *ts) {
+    // Accept subscribers and drain their queues every 10 ms
+    if (mon->stream_active) {
+        long long slot = (long long)ts->tv_sec * 100 + ts->tv_nsec / 10000000L;
+        if (slot != mon->stream_service_slot) {
+            stream_server_service(&mon->stream_server);
+            mon->stream_service_slot = slot;
+        }
+    }
+    
+    // Answer metrics scrapes on the same schedule
+    if (mon->metrics_active) {
+        long long slot = (long long)ts->tv_sec * 100 + ts->tv_nsec / 10000000L;
+        if (slot != mon->metrics_service_slot) {
+            // Never wait for the output thread; a busy lock retries on the next sample
+            if (!mon->output_thread_active) {
+                metrics_server_service(&mon->metrics_server, &mon->metrics, ts);
+                mon->metrics_service_slot = slot;
+            } else if (pthread_mutex_trylock(&mon->output_lock) == 0) {
+                metrics_server_service(&mon->metrics_server, &mon->metrics, ts);
+                pthread_mutex_unlock(&mon->output_lock);
+                mon->metrics_service_slot = slot;
+            }
+        }
+    }
+    
+    // Control commands run here, between two samples
+    if (mon->control_active) {
+        long long slot = (long long)ts->tv_sec * 100 + ts->tv_nsec / 10000000L;
+        if (slot != mon->control_service_slot) {
+            control_server_service(&mon->control_server, handle_control, mon, ts);
+            mon->control_service_slot = slot;
+        }
+    }
+    
+    if (mon->config.output_format == OUTPUT_FORMAT_PCAPNG && !mon->output_thread_active &&
+        ts->tv_sec != mon->last_flush_sec) {
+        output_flush(mon);
+        mon->last_flush_sec = ts->tv_sec;
+    }
+    
+    if (mon->config.handshake) {
+        report_handshake(mon, ts);
+    }
+    
+    if (mon->trigger_active && !trigger_capturing(&mon->trigger, ts) && trigger_check(&mon->trigger, ts)) {
+        dump_trigger(mon);
+    }
+    
+    if (mon->loopback_active) {
+        drive_loopback(mon, ts);
+    }
+    
+    // Partial batches wait at most 10 ms
+    if (mon->edge_batch_count > 0 &&
+        elapsed_ns(&mon->edge_batch_time, ts) >= 10000000LL) {
+        deliver_edges(mon);
+    }
+}
+
+// Compare a sample against the last known state and log every change
+static int detect_changes(cts_monitor_t *mon, const signal_state_t *current_state,
+                          const struct timespec *ts) {
+    int events_processed = 0;
+    
+    if (mon->metrics_active) {
+        metrics_sample(&mon->metrics, ts);
+    }
+    
+    // An edge seen now happened at some point since the previous sample
+    mon->sample_window_ns = elapsed_ns(&mon->last_sample_time, ts);
+    mon->last_sample_time = *ts;
+    
+    // Echoes are matched on the raw sample, before glitch filtering
+    if (mon->loopback_active) {
+        loopback_sample(&mon->loopback, current_state, ts);
+    }
+    
+    if (mon->glitch_active) {
+        events_processed = detect_filtered_changes(mon, current_state, ts);
+        mon->last_state = *current_state;
+        finish_sample(mon, ts);
+        return events_processed;
+    }
+    
+    // Signals are logged in signal_state_log_order, limited to the monitored set
+    int changes = signal_state_changes(&mon->last_state, current_state, mon->signal_mask);
+    for (int i = 0; changes != 0 && i < SIGNAL_COUNT; i++) {
+        signal_id_t signal = signal_state_log_order[i];
+        if (changes & (1 << signal)) {
+            log_signal_change(mon, signal, signal_state_level(&mon->last_state, signal),
+                              signal_state_level(current_state, signal), ts);
+            changes &= ~(1 << signal);
+            events_processed++;
         }
+    }
+    
+    // Update last known state
+    mon->last_state = *current_state;
+    
+    finish_sample(mon, ts);
+    
+    return events_processed;
+}
+
+// Setup event-driven monitoring; the backend decides how to wait for edges
+static int setup_signal_io(cts_monitor_t *mon) {
+    if (mon->config.verbose) {
+        printf("IRQ-mode: Waiting for %s backend events\n", mon->backend.ops->name);
+    }
+    
+    mon->irq_mode_active = 1;
+    return 0;
+}
+
+// Cleanup event-driven monitoring
+static void cleanup_signal_io(cts_monitor_t *mon) {
+    mon->irq_mode_active = 0;
+    
+    if (mon->config.verbose) {
+        printf("Event-driven monitoring disabled\n");
+    }
+}
+
+// Start the glitch filter from the initial signal state
+static void init_glitch_filter(cts_monitor_t *mon) {
+    mon->glitch_active = 0;
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (mon->config.min_pulse_us[i] > 0) {
+            mon->glitch_active = 1;
+        }
+    }
+    if (mon->glitch_active) {
+        glitch_filter_init(&mon->glitch_filter, mon->config.min_pulse_us, &mon->last_state);
+    }
+}
+
+// Arm the trigger from the initial signal state
+static int init_trigger(cts_monitor_t *mon) {
+    struct timespec now;
+    
+    mon->trigger_active = 0;
+    if (!mon->config.trigger) {
+        return 0;
+    }
+    
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (trigger_init(&mon->trigger, mon->config.trigger,
+                     mon->config.pre_trigger_edges ? mon->config.pre_trigger_edges : TRIGGER_DEFAULT_EDGES,
+                     mon->config.post_trigger_ns, &mon->last_state, &now) < 0) {
+        trigger_free(&mon->trigger);
+        return -1;
+    }
+    mon->trigger_active = 1;
+    return 0;
+}
+
+// Idle wait of the output thread between queue checks
+#define OUTPUT_THREAD_IDLE_NS 1000000L
+
+// Write a record queued by the sampling path
+static void write_queued(cts_monitor_t *mon, const output_queue_record_t *record) {
+    if (record->kind == OUTPUT_QUEUE_EDGE) {
+        format_edge(mon, (signal_id_t)record->signal, record->level, &record->ts);
+        if (record->timed) {
+            // Timed like on the sampling path, where the edge is flushed right away
+            if (mon->config.output_format != OUTPUT_FORMAT_PCAPNG) {
+                output_flush(mon);
+            }
+            record_write_latency(mon, &record->ts);
+        }
+    } else if (record->kind == OUTPUT_QUEUE_SWITCH) {
+        install_output(mon, record->stream);
+    } else {
+        output_printf(mon, &record->ts, 0, "%s", record->text);
+    }
+}
+
+// Format and write queued records at normal priority until stopped
+static void *output_thread_main(void *arg) {
+    cts_monitor_t *mon = arg;
+    struct sched_param param = { .sched_priority = 0 };
+    struct timespec idle = { 0, OUTPUT_THREAD_IDLE_NS };
+    
+    // Never run with the elevated priority of the capture thread
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    if (getpriority(PRIO_PROCESS, 0) < 0) {
+        setpriority(PRIO_PROCESS, 0, 0);
+    }
+    
+    for (;;) {
+        // Everything queued before the stop request is still written
+        int stop = __atomic_load_n(&mon->output_stop, __ATOMIC_ACQUIRE);
+        const output_queue_record_t *record;
+        int written = 0;
         
-        long long total_us = diff.tv_sec * 1000000LL + diff.tv_nsec / 1000;
-        snprintf(buffer, size, "%lld.%06lld", total_us / 1000000, total_us % 1000000);
+        while ((record = output_queue_peek(&mon->output_queue)) != NULL) {
+            write_queued(mon, record);
+            output_queue_release(&mon->output_queue);
+            written = 1;
+        }
+        if (written) {
+            output_flush(mon);
+        }
+        if (stop) {
+            return NULL;
+        }
+        nanosleep(&idle, NULL);
     }
 }
 
-// Read current CTS/RTS state
-static int read_signal_state(signal_state_t *state) {
-    int status;
-    
-    if (ioctl(serial_fd, TIOCMGET, &status) < 0) {
-        if (current_config.verbose) {
-            fprintf(stderr, "Error reading serial port status: %s\n", strerror(errno));
-        }
-        return -1;
+// Move formatting and writing of records to their own thread
+static int start_output_thread(cts_monitor_t *mon) {
+    sigset_t all, previous;
+    size_t slots = OUTPUT_QUEUE_DEFAULT_SLOTS;
+    
+    // A trigger dumps its whole pre-trigger buffer at once; the default
+    // size stays free for the edges captured while it is written
+    if (mon->trigger_active) {
+        slots += mon->config.pre_trigger_edges ? mon->config.pre_trigger_edges : TRIGGER_DEFAULT_EDGES;
+    }
+    
+    if (output_queue_init(&mon->output_queue, slots) < 0) {
+        return -1;
+    }
+    pthread_mutex_init(&mon->output_lock, NULL);
+    mon->output_stop = 0;
+    mon->output_thread_active = 1;
+    
+    // Signals are left to the capture thread
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    int ret = pthread_create(&mon->output_thread, NULL, output_thread_main, mon);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    
+    if (ret != 0) {
+        fprintf(stderr, "Error starting output thread: %s\n", strerror(ret));
+        mon->output_thread_active = 0;
+        pthread_mutex_destroy(&mon->output_lock);
+        output_queue_free(&mon->output_queue);
+        return -1;
+    }
+    return 0;
+}
+
+// Write the remaining queued records and end the output thread
+static void stop_output_thread(cts_monitor_t *mon) {
+    if (!mon->output_thread_active) {
+        return;
     }
     
-    state->cts = (status & TIOCM_CTS) ? 1 : 0;
-    state->rts = (status & TIOCM_RTS) ? 1 : 0;
-    state->dsr = (status & TIOCM_DSR) ? 1 : 0;  // Also read DSR for completeness
-    state->dtr = (status & TIOCM_DTR) ? 1 : 0;  // Also read DTR for completeness
+    __atomic_store_n(&mon->output_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(mon->output_thread, NULL);
+    mon->output_thread_active = 0;
     
-    return 0;
+    if (mon->output_queue.dropped > 0) {
+        fprintf(stderr, "Output thread fell behind: %llu records dropped\n",
+                mon->output_queue.dropped);
+    }
+    pthread_mutex_destroy(&mon->output_lock);
+    output_queue_free(&mon->output_queue);
 }
 
-// Log signal change
-static void log_signal_change(const char *signal_name, int old_state, int new_state) {
-    char timestamp[64];
-    get_timestamp(timestamp, sizeof(timestamp));
+// Release everything init_edge_path() set up
+static void close_edge_path(cts_monitor_t *mon) {
+    if (mon->trigger_active) {
+        trigger_free(&mon->trigger);
+        mon->trigger_active = 0;
+    }
     
-    const char *state_str = new_state ? "HIGH" : "LOW";
-    const char *transition = (old_state < new_state) ? "↑" : "↓";
+    if (mon->stream_active) {
+        stream_server_close(&mon->stream_server);
+        mon->stream_active = 0;
+    }
+    
+    if (mon->shm_active) {
+        shm_ring_writer_close(&mon->shm_ring);
+        mon->shm_active = 0;
+    }
     
-    fprintf(output_fp, "[%s] %s: %s %s\n", timestamp, signal_name, state_str, transition);
-    fflush(output_fp);
+    if (mon->metrics_active) {
+        metrics_server_close(&mon->metrics_server);
+        mon->metrics_active = 0;
+    }
     
-    if (current_config.verbose && output_fp != stdout) {
-        printf("[%s] %s: %s %s\n", timestamp, signal_name, state_str, transition);
+    if (mon->control_active) {
+        control_server_close(&mon->control_server);
+        mon->control_active = 0;
     }
 }
 
-// Setup high-frequency polling for IRQ mode (more reliable than SIGIO)
-static int setup_signal_io(void) {
-#ifdef HAVE_LIBFTDI1
-    // If using FTDI, we don't need to configure the serial file descriptor
-    if (using_ftdi) {
-        if (current_config.verbose) {
-            printf("IRQ-mode: Using FTDI direct GPIO monitoring (no select() needed)\n");
-            printf("FTDI device provides direct hardware event detection\n");
+// Set up everything edges flow through once the initial state is known
+static int init_edge_path(cts_monitor_t *mon) {
+    mon->loopback_active = 0;
+    if (mon->config.loopback) {
+        if (!mon->backend.ops->set_lines) {
+            fprintf(stderr, "The %s backend cannot drive RTS/DTR for a loopback test\n",
+                    mon->backend.ops->name);
+            return -1;
         }
-        irq_mode_active = 1;
-        return 0;
-    }
-#endif
-
-    // For standard serial devices, set up select()-based monitoring
-    if (serial_fd < 0) {
-        fprintf(stderr, "Serial device not properly initialized for IRQ mode\n");
-        return -1;
+        if (loopback_init(&mon->loopback, mon->config.loopback, mon->config.loopback_rate,
+                          mon->config.loopback_count, &mon->last_state, &mon->start_time) < 0) {
+            return -1;
+        }
+        mon->loopback_active = 1;
     }
     
-    // Set the serial port to non-blocking mode for select() monitoring
-    int flags = fcntl(serial_fd, F_GETFL);
-    if (flags < 0) {
-        fprintf(stderr, "Error getting serial port flags: %s\n", strerror(errno));
+    init_glitch_filter(mon);
+    if (init_trigger(mon) < 0) {
         return -1;
     }
     
-    // Make serial port non-blocking for better select() behavior
-    if (fcntl(serial_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
-        fprintf(stderr, "Error setting non-blocking mode: %s\n", strerror(errno));
-        return -1;
+    mon->stream_active = 0;
+    if (mon->config.stream_socket) {
+        if (stream_server_open(&mon->stream_server, mon->config.stream_socket,
+                               mon->config.stream_queue_size) < 0) {
+            close_edge_path(mon);
+            return -1;
+        }
+        mon->stream_active = 1;
     }
     
-    if (current_config.verbose) {
-        printf("IRQ-mode: Using select() system call for event-driven monitoring\n");
-        printf("Serial port set to non-blocking mode for interrupt-driven I/O\n");
+    mon->shm_active = 0;
+    if (mon->config.shm_name) {
+        if (shm_ring_writer_open(&mon->shm_ring, mon->config.shm_name, mon->config.shm_slots) < 0) {
+            close_edge_path(mon);
+            return -1;
+        }
+        mon->shm_active = 1;
     }
     
-    irq_mode_active = 1;
-    return 0;
-}
-
-// Cleanup signal-driven I/O
-static void cleanup_signal_io(void) {
-#ifdef HAVE_LIBFTDI1
-    // If using FTDI, no serial file descriptor cleanup needed
-    if (using_ftdi) {
-        irq_mode_active = 0;
-        if (current_config.verbose) {
-            printf("FTDI IRQ mode disabled\n");
+    metrics_init(&mon->metrics, &mon->start_time);
+    hdr_histogram_reset(&mon->detect_window_hist);
+    hdr_histogram_reset(&mon->write_latency_hist);
+    mon->last_sample_time = mon->start_time;
+    mon->metrics_active = 0;
+    if (mon->config.metrics_endpoint) {
+        if (metrics_server_open(&mon->metrics_server, mon->config.metrics_endpoint) < 0) {
+            close_edge_path(mon);
+            return -1;
         }
-        return;
+        mon->metrics_active = 1;
     }
-#endif
-
-    // For standard serial devices, restore blocking mode
-    if (serial_fd >= 0) {
-        // Restore blocking mode
-        int flags = fcntl(serial_fd, F_GETFL);
-        if (flags >= 0) {
-            fcntl(serial_fd, F_SETFL, flags & ~O_NONBLOCK);
+    
+    mon->control_active = 0;
+    if (mon->config.control_socket) {
+        if (control_server_open(&mon->control_server, mon->config.control_socket) < 0) {
+            close_edge_path(mon);
+            return -1;
         }
+        mon->control_active = 1;
     }
     
-    irq_mode_active = 0;
-    
-    if (current_config.verbose) {
-        printf("Event-driven monitoring disabled, restored blocking mode\n");
-    }
+    mon->output_state = mon->last_state;
+    write_output_header(mon, &mon->start_time, &mon->last_state);
+    return 0;
 }
 
-int cts_monitor_init(const monitor_config_t *config) {
-    if (initialized) {
-        if (config->verbose) printf("Monitor already initialized\n");
-        return 0;
+cts_monitor_t *cts_monitor_create(const monitor_config_t *config) {
+    void *memory;
+    
+    // All buffers are part of the instance, allocated once here
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, sizeof(cts_monitor_t)) != 0) {
+        fprintf(stderr, "Out of memory allocating monitor\n");
+        return NULL;
     }
+    cts_monitor_t *mon = memory;
+    memset(mon, 0, sizeof(*mon));
     
     // Copy configuration
-    current_config = *config;
+    mon->config = *config;
+    pulse_stats_init(&mon->pulse_stats);
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        hdr_histogram_reset(&mon->width_hist[i][0]);
+        hdr_histogram_reset(&mon->width_hist[i][1]);
+    }
+    mon->handshake_active = mon->config.handshake || mon->config.hist_file != NULL;
+    if (mon->handshake_active) {
+        handshake_init(&mon->handshake,
+                       mon->config.handshake ? mon->config.handshake_timeout_us * 1000LL : 0);
+    }
     
-    // Record start time for relative timestamps
-    clock_gettime(CLOCK_REALTIME, &start_time);
+    // DSR/DTR only produce edges in verbose mode unless chosen explicitly
+    mon->signal_mask = mon->config.signal_mask;
+    if (mon->signal_mask == 0) {
+        mon->signal_mask = mon->config.verbose ? (1 << SIGNAL_COUNT) - 1
+                                               : (1 << SIGNAL_CTS) | (1 << SIGNAL_RTS);
+    }
+    if (mon->signal_mask < 0 || mon->signal_mask >= (1 << SIGNAL_COUNT)) {
+        fprintf(stderr, "Invalid signal set 0x%x\n", (unsigned)mon->signal_mask);
+        free(mon);
+        return NULL;
+    }
+    if (mon->config.handshake &&
+        (~mon->signal_mask & ((1 << SIGNAL_CTS) | (1 << SIGNAL_RTS)))) {
+        fprintf(stderr, "Handshake analysis needs CTS and RTS in the signal set\n");
+        free(mon);
+        return NULL;
+    }
     
     if (config->verbose) {
         printf("Initializing CTS Monitor...\n");
         printf("Serial device: %s\n", config->serial_device);
     }
 
+    if (capture_backend_open(&mon->backend, &mon->config) < 0) {
+        free(mon);
+        return NULL;
+    }
 #ifdef HAVE_LIBFTDI1
-    // Check if this is an FTDI device
-    int is_ftdi = cts_monitor_is_ftdi_device(config->serial_device);
-    if (is_ftdi == 1) {
-        if (config->verbose) {
-            printf("FTDI device detected - attempting direct GPIO monitoring\n");
-        }
-        
-        // Try to initialize FTDI interface
-        if (cts_monitor_init_ftdi() == 0) {
-            using_ftdi = 1;
-            
-            // Read initial state from FTDI
-            unsigned char pins;
-            if (ftdi_read_pins(&ftdi_ctx, &pins) == 0) {
-                last_state.cts = (pins & 0x10) ? 1 : 0;
-                last_state.rts = (pins & 0x20) ? 1 : 0;
-                last_state.dsr = (pins & 0x40) ? 1 : 0;
-                last_state.dtr = (pins & 0x80) ? 1 : 0;
-            }
-            
-            initialized = 1;
-            
-            if (config->verbose) {
-                printf("FTDI direct GPIO monitoring initialized successfully\n");
-                printf("Initial CTS: %s, RTS: %s\n", 
-                       last_state.cts ? "HIGH" : "LOW", 
-                       last_state.rts ? "HIGH" : "LOW");
-            }
-            
-            return 0;
-        } else {
-            if (config->verbose) {
-                printf("FTDI initialization failed, falling back to standard serial interface\n");
-            }
-        }
+    if (mon->backend.ops == &ftdi_backend_ops) {
+        mon->config.device_type = DEVICE_TYPE_FTDI;
     }
 #endif
     
-    // Standard serial interface initialization
-    using_ftdi = 0;
-    
-    // Open serial device
-    serial_fd = open(config->serial_device, O_RDWR | O_NOCTTY | O_NONBLOCK);
-    if (serial_fd < 0) {
-        fprintf(stderr, "Error opening serial device %s: %s\n", 
-                config->serial_device, strerror(errno));
-        return -1;
-    }
-    
-    // Configure serial port (minimal configuration, just for control signals)
-    struct termios tty;
-    if (tcgetattr(serial_fd, &tty) < 0) {
-        fprintf(stderr, "Error getting serial port attributes: %s\n", strerror(errno));
-        close(serial_fd);
-        return -1;
-    }
-    
-    // Set minimal configuration - we only care about control signals
-    cfmakeraw(&tty);
-    tty.c_cflag |= CLOCAL;  // Ignore modem control lines
-    tty.c_cflag &= ~CRTSCTS;  // Disable hardware flow control initially
-    
-    if (tcsetattr(serial_fd, TCSANOW, &tty) < 0) {
-        fprintf(stderr, "Error setting serial port attributes: %s\n", strerror(errno));
-        close(serial_fd);
-        return -1;
-    }
-    
     // Open output file if specified
-    if (config->output_file) {
-        output_fp = fopen(config->output_file, "w");
-        if (!output_fp) {
-            fprintf(stderr, "Error opening output file %s: %s\n", 
-                    config->output_file, strerror(errno));
-            close(serial_fd);
-            return -1;
-        }
-    } else {
-        output_fp = stdout;
+    if (open_output(mon) < 0) {
+        capture_backend_close(&mon->backend);
+        free(mon);
+        return NULL;
     }
     
-    // Read initial state
-    if (read_signal_state(&last_state) < 0) {
+    // Read initial state; its sample time is the start for relative timestamps
+    if (read_signal_state(mon, &mon->last_state, &mon->start_time) != 0) {
         fprintf(stderr, "Failed to read initial signal state\n");
-        if (output_fp != stdout) fclose(output_fp);
-        close(serial_fd);
-        return -1;
+        close_output(mon);
+        capture_backend_close(&mon->backend);
+        free(mon);
+        return NULL;
+    }
+    if (init_edge_path(mon) < 0) {
+        close_output(mon);
+        capture_backend_close(&mon->backend);
+        free(mon);
+        return NULL;
     }
     
     // Log initial state
     if (config->verbose) {
+        struct timespec ts = mon->start_time;
         char timestamp[64];
-        get_timestamp(timestamp, sizeof(timestamp));
-        fprintf(output_fp, "[%s] === CTS Monitor Started ===\n", timestamp);
-        fprintf(output_fp, "[%s] Initial state - CTS: %s, RTS: %s\n", 
-                timestamp,
-                last_state.cts ? "HIGH" : "LOW",
-                last_state.rts ? "HIGH" : "LOW");
-        fflush(output_fp);
+        get_timestamp(mon, &ts, timestamp, sizeof(timestamp));
+        output_printf(mon, &ts, 0, "[%s] === CTS Monitor Started ===\n", timestamp);
+        output_printf(mon, &ts, 0, "[%s] Initial state - CTS: %s, RTS: %s\n", 
+                      timestamp,
+                      mon->last_state.cts ? "HIGH" : "LOW",
+                      mon->last_state.rts ? "HIGH" : "LOW");
+        output_flush(mon);
     }
     
-    initialized = 1;
+    if (mon->config.output_thread && mon->config.output_backend != OUTPUT_BACKEND_NONE &&
+        start_output_thread(mon) < 0) {
+        close_edge_path(mon);
+        close_output(mon);
+        capture_backend_close(&mon->backend);
+        free(mon);
+        return NULL;
+    }
     
     if (config->verbose) {
         printf("CTS Monitor initialized successfully\n");
         printf("Initial CTS: %s, RTS: %s\n", 
-               last_state.cts ? "HIGH" : "LOW", 
-               last_state.rts ? "HIGH" : "LOW");
+               mon->last_state.cts ? "HIGH" : "LOW", 
+               mon->last_state.rts ? "HIGH" : "LOW");
     }
     
-    return 0;
+    return mon;
 }
 
-int cts_monitor_update() {
-    if (!initialized) {
-        fprintf(stderr, "Monitor not initialized\n");
-        return -1;
-    }
-
-#ifdef HAVE_LIBFTDI1
-    if (using_ftdi) {
-        return cts_monitor_update_ftdi();
-    }
-#endif
-    
+int cts_monitor_update(cts_monitor_t *mon) {
     signal_state_t current_state;
+    struct timespec sample_time;
     
     // Read current signal state
-    if (read_signal_state(&current_state) < 0) {
-        return -1;
+    int ret = read_signal_state(mon, &current_state, &sample_time);
+    if (ret != 0) {
+        return ret < 0 ? -1 : 0;
     }
     
     // Check for changes and log them
-    if (current_state.cts != last_state.cts) {
-        log_signal_change("CTS", last_state.cts, current_state.cts);
+    detect_changes(mon, &current_state, &sample_time);
+    
+    return 0;
+}
+
+void cts_monitor_destroy(cts_monitor_t *mon) {
+    if (!mon) {
+        return;
     }
     
-    if (current_state.rts != last_state.rts) {
-        log_signal_change("RTS", last_state.rts, current_state.rts);
+    if (mon->edge_callback) {
+        cts_monitor_set_edge_callback(mon, NULL, NULL, 0);
     }
     
-    // Also monitor DSR/DTR if verbose mode (optional)
-    if (current_config.verbose) {
-        if (current_state.dsr != last_state.dsr) {
-            log_signal_change("DSR", last_state.dsr, current_state.dsr);
-        }
-        
-        if (current_state.dtr != last_state.dtr) {
-            log_signal_change("DTR", last_state.dtr, current_state.dtr);
-        }
+    // Stop IRQ mode if active
+    if (mon->irq_mode_active) {
+        cts_monitor_stop_irq(mon);
     }
     
-    // Update last known state
-    last_state = current_state;
+    stop_output_thread(mon);
     
-    return 0;
-}
-
-void cts_monitor_cleanup() {
-    // Prevent double cleanup
-    if (!initialized || cleanup_in_progress) {
-        return;
+    if (mon->config.stats) {
+        pulse_stats_print(&mon->pulse_stats, stdout);
     }
     
-    cleanup_in_progress = 1;  // Set flag to prevent re-entry
+    if (mon->config.handshake) {
+        print_handshake_summary(mon, stdout);
+    }
     
-    // Stop IRQ mode if active
-    if (irq_mode_active) {
-        cts_monitor_stop_irq();
+    if (mon->glitch_active) {
+        glitch_filter_print(&mon->glitch_filter, stdout);
     }
-
-#ifdef HAVE_LIBFTDI1
-    // Cleanup FTDI if used
-    if (using_ftdi) {
-        cts_monitor_cleanup_ftdi();
+    
+    if (mon->config.latency) {
+        print_latency(mon, stdout);
+    }
+    
+    if (mon->loopback_active) {
+        loopback_print(&mon->loopback, mode_name(mon), stdout);
+    }
+    
+    if (mon->config.hist_file) {
+        print_histograms(mon, stdout);
+        write_histograms(mon);
     }
-#endif
     
     // Write final message to output file before closing it
-    if (current_config.verbose && output_fp && (output_fp == stdout || output_fp != NULL)) {
+    if (mon->config.verbose && (mon->output_fp || mon->mmap_active || mon->rotate_active)) {
+        struct timespec ts;
         char timestamp[64];
-        get_timestamp(timestamp, sizeof(timestamp));
-        fprintf(output_fp, "[%s] === CTS Monitor Stopped ===\n", timestamp);
-        fflush(output_fp);  // Ensure output is written
+        clock_gettime(CLOCK_REALTIME, &ts);
+        get_timestamp(mon, &ts, timestamp, sizeof(timestamp));
+        output_printf(mon, &ts, 0, "[%s] === CTS Monitor Stopped ===\n", timestamp);
+        output_flush(mon);  // Ensure output is written
     }
     
-    if (current_config.verbose) {
+    if (mon->config.verbose) {
         printf("Cleaning up CTS Monitor...\n");
     }
     
-    if (serial_fd >= 0) {
-        close(serial_fd);
-        serial_fd = -1;
-    }
+    capture_backend_close(&mon->backend);
     
     // Close output file after writing final message
-    if (output_fp && output_fp != stdout) {
-        fclose(output_fp);
-        output_fp = NULL;
-    }
+    close_output(mon);
+    close_edge_path(mon);
     
-    initialized = 0;
-    cleanup_in_progress = 0;  // Reset flag
-    
-    if (current_config.verbose) {
+    if (mon->config.verbose) {
         printf("CTS Monitor cleanup complete\n");
     }
+    free(mon);
 }
 
-// Utility function to get current signal state
-int cts_monitor_get_state(signal_state_t *state) {
-    if (!initialized) {
-        return -1;
+int cts_monitor_set_edge_callback(cts_monitor_t *mon, cts_monitor_edge_callback_t callback,
+                                  void *user_data, size_t batch_size) {
+    if (mon->edge_callback) {
+        deliver_edges(mon);
+    }
+    if (!callback) {
+        mon->edge_batch_size = 0;
+        mon->edge_callback = NULL;
+        mon->edge_callback_data = NULL;
+        return 0;
     }
     
-    return read_signal_state(state);
-}
-
-// Start IRQ-driven monitoring
-int cts_monitor_start_irq(void) {
-    if (!initialized) {
-        fprintf(stderr, "Monitor not initialized\n");
-        return -1;
+    if (batch_size == 0) {
+        batch_size = CTS_MONITOR_DEFAULT_BATCH;
     }
-    
-    if (current_config.mode != MONITOR_MODE_IRQ) {
-        if (current_config.verbose) {
-            printf("Not configured for IRQ mode\n");
-        }
+    if (batch_size > CTS_MONITOR_MAX_BATCH) {
+        fprintf(stderr, "Callback batch of %zu edges exceeds the maximum of %d\n",
+                batch_size, CTS_MONITOR_MAX_BATCH);
         return -1;
     }
+    mon->edge_batch_size = batch_size;
+    mon->edge_callback = callback;
+    mon->edge_callback_data = user_data;
+    return 0;
+}
+
+// Start a new plain output file after it was moved away, e.g. by logrotate;
+// segmented outputs name their own files and are left alone
+int cts_monitor_reopen_output(cts_monitor_t *mon) {
+    char error[PATH_MAX + 64];
     
-    if (irq_mode_active) {
-        if (current_config.verbose) {
-            printf("IRQ mode already active\n");
-        }
+    if (!output_switchable(mon) || !mon->config.output_file) {
         return 0;
     }
-    
-    if (setup_signal_io() < 0) {
+    if (switch_output(mon, mon->config.output_file, error, sizeof(error)) < 0) {
+        fprintf(stderr, "Error reopening output file: %s\n", error);
         return -1;
     }
-    
-    if (current_config.verbose) {
-        printf("High-frequency polling mode started (10μs intervals)\n");
-    }
-    
     return 0;
 }
 
-// Stop IRQ-driven monitoring
-int cts_monitor_stop_irq(void) {
-    if (!irq_mode_active) {
-        return 0;
-    }
+int cts_monitor_reconfigure(cts_monitor_t *mon, const cts_monitor_settings_t *settings) {
+    char error[PATH_MAX + 64];
     
-    cleanup_signal_io();
-    
-    if (current_config.verbose) {
-        printf("High-frequency polling mode stopped\n");
+    if (apply_settings(mon, settings, error, sizeof(error)) < 0) {
+        fprintf(stderr, "Reconfiguration rejected: %s\n", error);
+        return -1;
     }
-    
     return 0;
 }
 
-// Process pending IRQ events using select() for true event-driven monitoring
-int cts_monitor_process_irq_events(void) {
-    if (!initialized || !irq_mode_active) {
-        return -1;
+void cts_monitor_flush_edges(cts_monitor_t *mon) {
+    if (mon->edge_callback) {
+        deliver_edges(mon);
     }
+}
 
-#ifdef HAVE_LIBFTDI1
-    if (using_ftdi) {
-        return cts_monitor_update_ftdi();
+// Utility function to get current signal state
+int cts_monitor_get_state(cts_monitor_t *mon, signal_state_t *state) {
+    struct timespec ts;
+    return read_signal_state(mon, state, &ts) == 0 ? 0 : -1;
+}
+
+// Print statistics collected so far
+void cts_monitor_print_stats(cts_monitor_t *mon, FILE *fp) {
+    if (mon->config.stats) {
+        pulse_stats_print(&mon->pulse_stats, fp);
     }
-#endif
-    
-    // Use select() to wait for activity on the serial port
-    fd_set readfds, errorfds;
-    struct timeval timeout;
-    
-    FD_ZERO(&readfds);
-    FD_ZERO(&errorfds);
-    FD_SET(serial_fd, &readfds);
-    FD_SET(serial_fd, &errorfds);
     
-    // Set timeout to 100ms to allow for periodic checking
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 100000;  // 100ms
-    
-    int result = select(serial_fd + 1, &readfds, NULL, &errorfds, &timeout);
+    if (mon->config.handshake) {
+        print_handshake_summary(mon, fp);
+    }
     
-    if (result < 0) {
-        if (errno != EINTR) {  // Ignore interruption by signals
-            fprintf(stderr, "select() failed: %s\n", strerror(errno));
-            return -1;
-        }
-        return 0;  // Interrupted by signal, not an error
+    if (mon->glitch_active) {
+        glitch_filter_print(&mon->glitch_filter, fp);
     }
     
-    if (result == 0) {
-        // Timeout occurred - check for signal changes anyway
-        // This ensures we don't miss state changes that don't trigger select()
-        signal_state_t current_state;
-        if (read_signal_state(&current_state) < 0) {
-            return -1;
-        }
-        
-        int events_processed = 0;
-        
-        // Check for changes and log them
-        if (current_state.cts != last_state.cts) {
-            log_signal_change("CTS", last_state.cts, current_state.cts);
-            events_processed++;
-        }
-        
-        if (current_state.rts != last_state.rts) {
-            log_signal_change("RTS", last_state.rts, current_state.rts);
-            events_processed++;
-        }
-        
-        // Also monitor DSR/DTR if verbose mode
-        if (current_config.verbose) {
-            if (current_state.dsr != last_state.dsr) {
-                log_signal_change("DSR", last_state.dsr, current_state.dsr);
-                events_processed++;
-            }
-            
-            if (current_state.dtr != last_state.dtr) {
-                log_signal_change("DTR", last_state.dtr, current_state.dtr);
-                events_processed++;
-            }
-        }
-        
-        // Update last known state
-        last_state = current_state;
-        
-        return events_processed;
+    if (mon->trigger_active) {
+        fprintf(fp, "Trigger %s fired %llu times (%s)\n", mon->config.trigger, mon->trigger.fired,
+                mon->trigger.capturing ? "capturing" : "armed");
     }
     
-    // Activity detected on serial port file descriptor
-    if (FD_ISSET(serial_fd, &readfds) || FD_ISSET(serial_fd, &errorfds)) {
-        // Read and discard any pending data to clear the file descriptor
-        char buffer[256];
-        while (read(serial_fd, buffer, sizeof(buffer)) > 0) {
-            // Discard data - we only care about control signal changes
-        }
-        
-        // Now check for signal state changes
-        signal_state_t current_state;
-        if (read_signal_state(&current_state) < 0) {
-            return -1;
+    if (mon->stream_active) {
+        int subscribers = 0;
+        for (int i = 0; i < STREAM_SERVER_MAX_CLIENTS; i++) {
+            subscribers += mon->stream_server.clients[i].state != STREAM_CLIENT_FREE;
         }
-        
-        int events_processed = 0;
-        
-        // Check for changes and log them
-        if (current_state.cts != last_state.cts) {
-            log_signal_change("CTS", last_state.cts, current_state.cts);
-            events_processed++;
-        }
-        
-        if (current_state.rts != last_state.rts) {
-            log_signal_change("RTS", last_state.rts, current_state.rts);
-            events_processed++;
-        }
-        
-        // Also monitor DSR/DTR if verbose mode
-        if (current_config.verbose) {
-            if (current_state.dsr != last_state.dsr) {
-                log_signal_change("DSR", last_state.dsr, current_state.dsr);
-                events_processed++;
-            }
-            
-            if (current_state.dtr != last_state.dtr) {
-                log_signal_change("DTR", last_state.dtr, current_state.dtr);
-                events_processed++;
-            }
-        }
-        
-        // Update last known state
-        last_state = current_state;
-        
-        return events_processed;
+        fprintf(fp, "Stream %s: %d clients, %lu disconnected for falling behind\n",
+                mon->config.stream_socket, subscribers, mon->stream_server.disconnected);
     }
     
-    return 0;  // No events processed
-}
-
-#ifdef HAVE_LIBFTDI1
-// Detect if device is an FTDI device by checking USB vendor/product ID
-int cts_monitor_is_ftdi_device(const char *device_path) {
-    // Extract device number from path like /dev/ttyUSB0
-    if (strncmp(device_path, "/dev/ttyUSB", 11) != 0) {
-        return 0;  // Not a USB serial device
+    if (mon->config.hist_file) {
+        print_histograms(mon, fp);
     }
     
-    // Initialize libusb to enumerate devices
-    libusb_context *ctx = NULL;
-    libusb_device **devs;
-    int ret, i = 0;
-    
-    ret = libusb_init(&ctx);
-    if (ret < 0) {
-        return -1;
+    if (mon->config.latency) {
+        print_latency(mon, fp);
     }
     
-    ssize_t cnt = libusb_get_device_list(ctx, &devs);
-    if (cnt < 0) {
-        libusb_exit(ctx);
-        return -1;
+    if (mon->loopback_active) {
+        loopback_print(&mon->loopback, mode_name(mon), fp);
     }
     
-    int found_ftdi = 0;
-    for (i = 0; i < cnt; i++) {
-        struct libusb_device_descriptor desc;
-        ret = libusb_get_device_descriptor(devs[i], &desc);
-        if (ret < 0) {
-            continue;
-        }
-        
-        // Check for FTDI vendor ID (0x0403)
-        if (desc.idVendor == 0x0403) {
-            // Common FTDI product IDs
-            if (desc.idProduct == 0x6001 ||  // FT232R
-                desc.idProduct == 0x6010 ||  // FT2232
-                desc.idProduct == 0x6011 ||  // FT4232
-                desc.idProduct == 0x6014 ||  // FT232H
-                desc.idProduct == 0x6015) {  // FT230X
-                found_ftdi = 1;
-                break;
-            }
-        }
+    if (mon->output_thread_active && mon->output_queue.dropped > 0) {
+        fprintf(fp, "Output thread fell behind: %llu records dropped\n",
+                mon->output_queue.dropped);
     }
-    
-    libusb_free_device_list(devs, 1);
-    libusb_exit(ctx);
-    
-    return found_ftdi;
 }
 
-// Initialize FTDI-specific monitoring
-int cts_monitor_init_ftdi(void) {
-    if (ftdi_initialized) {
-        return 0;  // Already initialized
-    }
-    
-    // Initialize FTDI context
-    if (ftdi_init(&ftdi_ctx) < 0) {
-        fprintf(stderr, "ftdi_init failed: %s\n", ftdi_get_error_string(&ftdi_ctx));
+// Start IRQ-driven monitoring
+int cts_monitor_start_irq(cts_monitor_t *mon) {
+    if (mon->config.mode != MONITOR_MODE_IRQ) {
+        if (mon->config.verbose) {
+            printf("Not configured for IRQ mode\n");
+        }
         return -1;
     }
     
-    // Find and open the first FTDI device
-    if (ftdi_usb_open(&ftdi_ctx, 0x0403, 0x6001) < 0) {
-        // Try other common FTDI product IDs
-        if (ftdi_usb_open(&ftdi_ctx, 0x0403, 0x6010) < 0 &&
-            ftdi_usb_open(&ftdi_ctx, 0x0403, 0x6014) < 0 &&
-            ftdi_usb_open(&ftdi_ctx, 0x0403, 0x6015) < 0) {
-            if (current_config.verbose) {
-                fprintf(stderr, "Unable to open FTDI device: %s\n", 
-                        ftdi_get_error_string(&ftdi_ctx));
-                fprintf(stderr, "Falling back to standard serial interface\n");
-            }
-            ftdi_deinit(&ftdi_ctx);
-            return -1;
+    if (mon->irq_mode_active) {
+        if (mon->config.verbose) {
+            printf("IRQ mode already active\n");
         }
+        return 0;
     }
     
-    // Set bitbang mode to read CTS/RTS pins directly
-    // This allows us to monitor the actual GPIO pins
-    if (ftdi_set_bitmode(&ftdi_ctx, 0xFF, BITMODE_BITBANG) < 0) {
-        fprintf(stderr, "Unable to set bitbang mode: %s\n", 
-                ftdi_get_error_string(&ftdi_ctx));
-        ftdi_usb_close(&ftdi_ctx);
-        ftdi_deinit(&ftdi_ctx);
+    if (setup_signal_io(mon) < 0) {
         return -1;
     }
     
-    ftdi_initialized = 1;
-    using_ftdi = 1;
-    
-    if (current_config.verbose) {
-        printf("FTDI device initialized successfully\n");
-        printf("Using direct GPIO pin monitoring for ultra-low latency\n");
+    if (mon->config.verbose) {
+        printf("High-frequency polling mode started (10μs intervals)\n");
     }
     
     return 0;
 }
 
-// Update FTDI device monitoring (read GPIO pins directly)
-int cts_monitor_update_ftdi(void) {
-    if (!ftdi_initialized) {
-        return -1;
-    }
-    
-    unsigned char pins;
-    int ret = ftdi_read_pins(&ftdi_ctx, &pins);
-    if (ret < 0) {
-        if (current_config.verbose) {
-            fprintf(stderr, "Error reading FTDI pins: %s\n", 
-                    ftdi_get_error_string(&ftdi_ctx));
-        }
-        return -1;
-    }
-    
-    // Map GPIO pins to CTS/RTS signals
-    // Pin mapping may vary by FTDI chip type - this is for FT232R
-    signal_state_t current_state;
-    current_state.cts = (pins & 0x10) ? 1 : 0;  // CTS is typically pin 4 (bit 4)
-    current_state.rts = (pins & 0x20) ? 1 : 0;  // RTS is typically pin 5 (bit 5)
-    current_state.dsr = (pins & 0x40) ? 1 : 0;  // DSR is typically pin 6 (bit 6)
-    current_state.dtr = (pins & 0x80) ? 1 : 0;  // DTR is typically pin 7 (bit 7)
-    
-    int events_processed = 0;
-    
-    // Check for changes and log them
-    if (current_state.cts != last_state.cts) {
-        log_signal_change("CTS", last_state.cts, current_state.cts);
-        events_processed++;
+// Stop IRQ-driven monitoring
+int cts_monitor_stop_irq(cts_monitor_t *mon) {
+    if (!mon->irq_mode_active) {
+        return 0;
     }
     
-    if (current_state.rts != last_state.rts) {
-        log_signal_change("RTS", last_state.rts, current_state.rts);
-        events_processed++;
-    }
+    cleanup_signal_io(mon);
     
-    // Also monitor DSR/DTR if verbose mode
-    if (current_config.verbose) {
-        if (current_state.dsr != last_state.dsr) {
-            log_signal_change("DSR", last_state.dsr, current_state.dsr);
-            events_processed++;
-        }
-        
-        if (current_state.dtr != last_state.dtr) {
-            log_signal_change("DTR", last_state.dtr, current_state.dtr);
-            events_processed++;
-        }
+    if (mon->config.verbose) {
+        printf("High-frequency polling mode stopped\n");
     }
     
-    // Update last known state
-    last_state = current_state;
-    
-    return events_processed;
+    return 0;
 }
 
-// Cleanup FTDI resources
-void cts_monitor_cleanup_ftdi(void) {
-    if (!ftdi_initialized) {
-        return;
-    }
-    
-    if (current_config.verbose) {
-        printf("FTDI device cleanup starting...\n");
+// Wait for backend events and process the resulting sample
+int cts_monitor_process_irq_events(cts_monitor_t *mon) {
+    if (!mon->irq_mode_active) {
+        return -1;
     }
     
-    // Close USB connection safely
-    if (ftdi_initialized) {
-        int ret = ftdi_usb_close(&ftdi_ctx);
-        if (ret < 0 && current_config.verbose) {
-            printf("Warning: FTDI USB close returned error: %s\n", ftdi_get_error_string(&ftdi_ctx));
+    // Wait for activity; on timeout check anyway so changes that do not
+    // wake the backend are still seen. Loopback steps cut the wait short.
+    int timeout_ms = 100;
+    if (mon->loopback_active) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        long long until_due = loopback_until_due(&mon->loopback, &now);
+        if (until_due >= 0 && until_due < timeout_ms * 1000000LL) {
+            timeout_ms = (int)((until_due + 999999) / 1000000);
         }
     }
+    if (mon->backend.ops->wait_edge(&mon->backend, timeout_ms) < 0) {
+        return -1;
+    }
     
-    // Deinitialize FTDI context
-    ftdi_deinit(&ftdi_ctx);
-    
-    // Reset flags
-    ftdi_initialized = 0;
-    using_ftdi = 0;
-    
-    if (current_config.verbose) {
-        printf("FTDI device cleanup complete\n");
+    signal_state_t current_state;
+    struct timespec sample_time;
+    int ret = read_signal_state(mon, &current_state, &sample_time);
+    if (ret != 0) {
+        return ret < 0 ? -1 : 0;
     }
+    
+    // Check for changes and log them
+    return detect_changes(mon, &current_state, &sample_time);
+}
+
+// Check whether the capture source has run out of input
+int cts_monitor_finished(const cts_monitor_t *mon) {
+    return mon->input_finished;
 }
-#endif
\ No newline at end of file
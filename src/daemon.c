@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "daemon.h"
+
+int daemon_detach(daemon_t *daemon) {
+    int fds[2];
+
+    daemon->ready_fd = -1;
+    daemon->pid_fd = -1;
+    daemon->pidfile = NULL;
+
+    if (pipe(fds) < 0) {
+        fprintf(stderr, "Error creating daemon status pipe: %s\n", strerror(errno));
+        return -1;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error forking daemon: %s\n", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid > 0) {
+        // Wait for the daemon's verdict; EOF means it died during startup
+        char status = 1;
+        ssize_t len;
+        close(fds[1]);
+        do {
+            len = read(fds[0], &status, 1);
+        } while (len < 0 && errno == EINTR);
+        waitpid(pid, NULL, 0);
+        _exit(len == 1 && status == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[0]);
+    if (setsid() < 0) {
+        fprintf(stderr, "Error creating daemon session: %s\n", strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+
+    // The second child is no session leader and can never regain a terminal
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error forking daemon: %s\n", strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+    if (pid > 0) {
+        _exit(EXIT_SUCCESS);
+    }
+
+    umask(022);
+    daemon->ready_fd = fds[1];
+    return 0;
+}
+
+int daemon_write_pidfile(daemon_t *daemon, const char *path) {
+    char pid[32];
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening pidfile %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    // The lock lives as long as the process, so a stale pidfile never blocks a restart
+    if (fcntl(fd, F_SETLK, &lock) < 0) {
+        ssize_t len = read(fd, pid, sizeof(pid) - 1);
+        pid[len > 0 ? len : 0] = '\0';
+        pid[strcspn(pid, "\n")] = '\0';
+        fprintf(stderr, "Another instance is running (pid %s, pidfile %s)\n",
+                pid[0] ? pid : "unknown", path);
+        close(fd);
+        return -1;
+    }
+
+    int len = snprintf(pid, sizeof(pid), "%ld\n", (long)getpid());
+    if (ftruncate(fd, 0) < 0 || write(fd, pid, (size_t)len) != len) {
+        fprintf(stderr, "Error writing pidfile %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    daemon->pid_fd = fd;
+    daemon->pidfile = path;
+    return 0;
+}
+
+void daemon_ready(daemon_t *daemon, int ok) {
+    char status = ok ? 0 : 1;
+
+    if (daemon->ready_fd < 0) {
+        return;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    if (ok) {
+        int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+            if (null_fd > STDERR_FILENO) {
+                close(null_fd);
+            }
+        }
+    }
+
+    // Report last, so the parent only exits once the terminal is released
+    if (write(daemon->ready_fd, &status, 1) != 1) {
+        // The parent is gone; nobody is left to tell
+    }
+    close(daemon->ready_fd);
+    daemon->ready_fd = -1;
+}
+
+void daemon_cleanup(daemon_t *daemon) {
+    if (daemon->pid_fd >= 0) {
+        unlink(daemon->pidfile);
+        close(daemon->pid_fd);
+        daemon->pid_fd = -1;
+    }
+}
+
+int daemon_raise_priority(int priority) {
+    struct sched_param param = { .sched_priority = priority };
+
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret == 0) {
+        return 0;
+    }
+
+    // RLIMIT_NICE may still allow a better nice value without CAP_SYS_NICE
+    if (setpriority(PRIO_PROCESS, 0, DAEMON_FALLBACK_NICE) == 0) {
+        fprintf(stderr, "Warning: SCHED_FIFO not permitted (%s), capturing at nice %d\n",
+                strerror(ret), DAEMON_FALLBACK_NICE);
+        return 0;
+    }
+
+    fprintf(stderr, "Warning: Cannot raise capture priority: %s\n", strerror(ret));
+    return -1;
+}
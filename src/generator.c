@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include "generator.h"
+#include "timestamp.h"
+
+// Lead time between starting the run and the first transition
+#define GENERATOR_LEAD_NS 1000000LL
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+// Parse a duration with ns, us, ms or s suffix (default us)
+static int parse_duration(const char *text, long long *ns) {
+    char *end;
+    double value = strtod(text, &end);
+    double scale;
+
+    if (end == text || value <= 0.0) {
+        return -1;
+    }
+    if (strcmp(end, "ns") == 0) {
+        scale = 1.0;
+    } else if (*end == '\0' || strcmp(end, "us") == 0) {
+        scale = 1e3;
+    } else if (strcmp(end, "ms") == 0) {
+        scale = 1e6;
+    } else if (strcmp(end, "s") == 0) {
+        scale = 1e9;
+    } else {
+        return -1;
+    }
+    *ns = (long long)(value * scale + 0.5);
+    return *ns > 0 ? 0 : -1;
+}
+
+// Parse "SIG=LEVEL" for a drivable line
+static int parse_level(const char *token, generator_step_t *step) {
+    const char *eq = strchr(token, '=');
+    int signal;
+    int level;
+
+    if (!eq) {
+        return -1;
+    }
+    if (eq - token == 3 && strncasecmp(token, "RTS", 3) == 0) {
+        signal = SIGNAL_RTS;
+    } else if (eq - token == 3 && strncasecmp(token, "DTR", 3) == 0) {
+        signal = SIGNAL_DTR;
+    } else {
+        return -1;
+    }
+
+    const char *value = eq + 1;
+    if (strcmp(value, "1") == 0 || strcasecmp(value, "HIGH") == 0) {
+        level = 1;
+    } else if (strcmp(value, "0") == 0 || strcasecmp(value, "LOW") == 0) {
+        level = 0;
+    } else {
+        return -1;
+    }
+
+    step->mask |= 1 << signal;
+    step->levels = level ? (step->levels | (1 << signal)) : (step->levels & ~(1 << signal));
+    return 0;
+}
+
+// Parse one pattern line; returns 1 for a transition, 0 for a blank line
+static int parse_line(char *line, generator_step_t *step) {
+    char *comment = strchr(line, '#');
+    int have_duration = 0;
+    char *save;
+
+    if (comment) {
+        *comment = '\0';
+    }
+    memset(step, 0, sizeof(*step));
+
+    for (char *token = strtok_r(line, " \t\r\n", &save); token;
+         token = strtok_r(NULL, " \t\r\n", &save)) {
+        if (strchr(token, '=')) {
+            if (parse_level(token, step) < 0) {
+                return -1;
+            }
+        } else if (have_duration || parse_duration(token, &step->duration_ns) < 0) {
+            return -1;
+        } else {
+            have_duration = 1;
+        }
+    }
+
+    if (!have_duration && step->mask == 0) {
+        return 0;
+    }
+    return have_duration && step->mask ? 1 : -1;
+}
+
+int generator_load(generator_pattern_t *pattern, const char *path) {
+    char *line = NULL;
+    size_t line_size = 0;
+    unsigned long line_number = 0;
+    generator_step_t step;
+
+    memset(pattern, 0, sizeof(*pattern));
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error opening pattern file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while (getline(&line, &line_size, fp) > 0) {
+        line_number++;
+        int ret = parse_line(line, &step);
+        if (ret < 0) {
+            fprintf(stderr, "%s:%lu: Expected RTS=LEVEL and/or DTR=LEVEL and a duration\n",
+                    path, line_number);
+            break;
+        }
+        if (ret == 0) {
+            continue;
+        }
+
+        if (pattern->count == pattern->capacity) {
+            size_t capacity = pattern->capacity ? pattern->capacity * 2 : 64;
+            generator_step_t *steps = realloc(pattern->steps, capacity * sizeof(*steps));
+            if (!steps) {
+                fprintf(stderr, "Out of memory loading %s\n", path);
+                break;
+            }
+            pattern->steps = steps;
+            pattern->capacity = capacity;
+        }
+        pattern->steps[pattern->count++] = step;
+        pattern->length_ns += step.duration_ns;
+    }
+
+    int failed = !feof(fp);
+    free(line);
+    fclose(fp);
+    if (!failed && pattern->count == 0) {
+        fprintf(stderr, "Pattern file %s has no transitions\n", path);
+        failed = 1;
+    }
+    if (failed) {
+        generator_free(pattern);
+        return -1;
+    }
+    return 0;
+}
+
+void generator_free(generator_pattern_t *pattern) {
+    free(pattern->steps);
+    memset(pattern, 0, sizeof(*pattern));
+}
+
+static void report_transition(FILE *report, unsigned long pass, size_t index,
+                              const generator_step_t *step, long long requested_ns,
+                              long long achieved_ns) {
+    char lines[32] = "";
+    size_t len = 0;
+
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (step->mask & (1 << i)) {
+            len += snprintf(lines + len, sizeof(lines) - len, "%s%s=%d", len ? " " : "",
+                            signal_names[i], (step->levels >> i) & 1);
+        }
+    }
+    fprintf(report, "%8lu %8zu %18.9f %18.9f %12.3f  %s\n", pass, index,
+            requested_ns / 1e9, achieved_ns / 1e9, (achieved_ns - requested_ns) / 1000.0, lines);
+}
+
+int generator_run(const generator_pattern_t *pattern, capture_backend_t *backend,
+                  unsigned long repeat, FILE *report, volatile int *running,
+                  generator_stats_t *stats) {
+    struct timespec origin, deadline, achieved, write_time;
+    long long requested_ns = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    fprintf(report, "#   PASS     STEP       REQUESTED_S        ACHIEVED_S     ERROR_US  LINES\n");
+
+    // The default 50 us timer slack would dominate the error of every wakeup
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+    origin = add_ns(&origin, GENERATOR_LEAD_NS);
+
+    for (unsigned long pass = 0; *running && (repeat == 0 || pass < repeat); pass++) {
+        for (size_t i = 0; i < pattern->count && *running; i++) {
+            const generator_step_t *step = &pattern->steps[i];
+
+            // Sleep to the absolute deadline; a signal ends playback
+            deadline = add_ns(&origin, requested_ns);
+            int ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+            if (ret == EINTR || !*running) {
+                break;
+            }
+
+            if (backend->ops->set_lines(backend, step->mask & step->levels,
+                                        step->mask & ~step->levels, &write_time) < 0) {
+                return -1;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &achieved);
+
+            long long achieved_ns = elapsed_ns(&origin, &achieved);
+            long long error_ns = achieved_ns - requested_ns;
+            hdr_histogram_record(&stats->error, error_ns > 0 ? (uint64_t)error_ns : 0);
+            stats->transitions++;
+            if (error_ns >= step->duration_ns) {
+                stats->overruns++;
+            }
+
+            // Report after the write so formatting never delays a transition
+            report_transition(report, pass, i, step, requested_ns, achieved_ns);
+            requested_ns += step->duration_ns;
+        }
+    }
+
+    fflush(report);
+    return 0;
+}
+
+void generator_print(const generator_stats_t *stats, FILE *fp) {
+    fprintf(fp, "=== Generator Timing Error (microseconds) ===\n");
+    fprintf(fp, "Transitions: %llu, overruns: %llu\n", stats->transitions, stats->overruns);
+    hdr_histogram_print_header(fp);
+    hdr_histogram_print(&stats->error, "generate.error", fp);
+    fflush(fp);
+}
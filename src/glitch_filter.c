@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "glitch_filter.h"
+#include "signal_state.h"
+#include "timestamp.h"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+void glitch_filter_init(glitch_filter_t *gf, const long min_pulse_us[SIGNAL_COUNT],
+                        const signal_state_t *initial) {
+    memset(gf, 0, sizeof(*gf));
+
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        gf->channels[i].min_pulse_ns = min_pulse_us[i] * 1000LL;
+    }
+    gf->channels[SIGNAL_CTS].committed = initial->cts;
+    gf->channels[SIGNAL_RTS].committed = initial->rts;
+    gf->channels[SIGNAL_DSR].committed = initial->dsr;
+    gf->channels[SIGNAL_DTR].committed = initial->dtr;
+}
+
+void glitch_filter_restart(glitch_filter_t *gf, signal_id_t signal, int level) {
+    gf->channels[signal].committed = level;
+    gf->channels[signal].pending = 0;
+}
+
+void glitch_filter_sample(glitch_filter_t *gf, signal_id_t signal, int level,
+                          const struct timespec *ts) {
+    glitch_channel_t *ch = &gf->channels[signal];
+
+    if (!ch->pending) {
+        if (level != ch->committed) {
+            ch->pending = 1;
+            ch->pending_time = *ts;
+        }
+        return;
+    }
+
+    // Back at the committed level before the change was released: a glitch.
+    // Changes that are already due have been released before this sample.
+    if (level == ch->committed && elapsed_ns(&ch->pending_time, ts) < ch->min_pulse_ns) {
+        ch->pending = 0;
+        ch->suppressed++;
+    }
+}
+
+int glitch_filter_next(glitch_filter_t *gf, const struct timespec *now,
+                       signal_id_t *signal, int *new_state, struct timespec *edge_time) {
+    glitch_channel_t *oldest = NULL;
+    signal_id_t oldest_index = SIGNAL_CTS;
+
+    // Oldest change whose level has been stable for its minimum pulse width;
+    // changes of the same sample come out in the unfiltered log order
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        signal_id_t id = signal_state_log_order[i];
+        glitch_channel_t *ch = &gf->channels[id];
+        if (ch->pending && elapsed_ns(&ch->pending_time, now) >= ch->min_pulse_ns &&
+            (!oldest || elapsed_ns(&ch->pending_time, &oldest->pending_time) > 0)) {
+            oldest = ch;
+            oldest_index = id;
+        }
+    }
+
+    if (!oldest) {
+        return 0;
+    }
+
+    oldest->committed = !oldest->committed;
+    oldest->pending = 0;
+    oldest->passed++;
+
+    *signal = oldest_index;
+    *new_state = oldest->committed;
+    *edge_time = oldest->pending_time;
+    return 1;
+}
+
+void glitch_filter_print(const glitch_filter_t *gf, FILE *fp) {
+    fprintf(fp, "=== Glitch Filter ===\n");
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        const glitch_channel_t *ch = &gf->channels[i];
+        if (ch->min_pulse_ns == 0 && ch->suppressed == 0) {
+            continue;
+        }
+        fprintf(fp, "%s: min pulse %lld us, passed %llu edges, suppressed %llu glitches\n",
+                signal_names[i], ch->min_pulse_ns / 1000, ch->passed, ch->suppressed);
+    }
+    fflush(fp);
+}
@@ -0,0 +1,111 @@
+#include <string.h>
+#include <time.h>
+#include "handshake.h"
+#include "timestamp.h"
+
+void handshake_init(handshake_t *hs, long long timeout_ns) {
+    memset(hs, 0, sizeof(*hs));
+    hs->timeout_ns = timeout_ns;
+    hs->minute = -1;
+}
+
+long long handshake_edge(handshake_t *hs, signal_id_t signal, int new_state,
+                         const struct timespec *ts) {
+    handshake_channel_t *ch = &hs->channels[new_state ? HANDSHAKE_ASSERT : HANDSHAKE_DEASSERT];
+
+    if (hs->minute < 0) {
+        hs->minute = (long)(ts->tv_sec / 60);
+    }
+
+    if (signal == SIGNAL_RTS) {
+        // A new request supersedes one that was never answered
+        if (ch->pending && !ch->timed_out) {
+            ch->unanswered++;
+        }
+        ch->request_time = *ts;
+        ch->pending = 1;
+        ch->timed_out = 0;
+
+        // RTS going the other way abandons the opposite request
+        handshake_channel_t *other = &hs->channels[new_state ? HANDSHAKE_DEASSERT : HANDSHAKE_ASSERT];
+        if (other->pending && !other->timed_out) {
+            other->unanswered++;
+        }
+        other->pending = 0;
+        return -1;
+    }
+
+    if (signal != SIGNAL_CTS || !ch->pending) {
+        return -1;  // Unsolicited CTS change or unrelated signal
+    }
+
+    long long latency = elapsed_ns(&ch->request_time, ts);
+    if (latency < 0) {
+        latency = 0;  // Wall clock stepped backwards
+    }
+
+    hdr_histogram_record(&ch->latency, (uint64_t)latency);
+    hdr_histogram_record(&ch->minute_latency, (uint64_t)latency);
+    ch->pairs++;
+    ch->pending = 0;
+
+    return latency;
+}
+
+void handshake_cancel(handshake_t *hs) {
+    for (int i = 0; i < HANDSHAKE_DIRECTIONS; i++) {
+        hs->channels[i].pending = 0;
+    }
+}
+
+int handshake_check_timeout(handshake_t *hs, const struct timespec *now,
+                            handshake_direction_t *direction) {
+    if (hs->timeout_ns <= 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < HANDSHAKE_DIRECTIONS; i++) {
+        handshake_channel_t *ch = &hs->channels[i];
+        if (ch->pending && !ch->timed_out &&
+            elapsed_ns(&ch->request_time, now) > hs->timeout_ns) {
+            ch->timed_out = 1;
+            ch->timeouts++;
+            ch->minute_timeouts++;
+            *direction = (handshake_direction_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int handshake_minute_due(handshake_t *hs, const struct timespec *now,
+                         struct timespec *minute_start) {
+    long minute = (long)(now->tv_sec / 60);
+
+    if (hs->minute < 0) {
+        hs->minute = minute;
+        return 0;
+    }
+    if (minute == hs->minute) {
+        return 0;
+    }
+
+    minute_start->tv_sec = (time_t)hs->minute * 60;
+    minute_start->tv_nsec = 0;
+    hs->minute = minute;
+
+    // Quiet minutes produce no report
+    for (int i = 0; i < HANDSHAKE_DIRECTIONS; i++) {
+        if (hs->channels[i].minute_latency.total || hs->channels[i].minute_timeouts) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void handshake_minute_reset(handshake_t *hs) {
+    for (int i = 0; i < HANDSHAKE_DIRECTIONS; i++) {
+        hdr_histogram_reset(&hs->channels[i].minute_latency);
+        hs->channels[i].minute_timeouts = 0;
+    }
+}
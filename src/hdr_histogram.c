@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "hdr_histogram.h"
+
+#define HDR_BLOB_MAGIC "CTSH"
+#define HDR_BLOB_VERSION 1
+
+// Map a value to its bucket: exact below 2^B, then 2^(B-1) sub-buckets per octave
+static unsigned int bucket_index(uint64_t value) {
+    if (value >> HDR_MAX_VALUE_BITS) {
+        value = (UINT64_C(1) << HDR_MAX_VALUE_BITS) - 1;
+    }
+    if (value < (UINT64_C(1) << HDR_SUB_BUCKET_BITS)) {
+        return (unsigned int)value;
+    }
+
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HDR_SUB_BUCKET_BITS + 1;
+    return ((unsigned int)shift << (HDR_SUB_BUCKET_BITS - 1)) + (unsigned int)(value >> shift);
+}
+
+// Highest value that maps to a bucket
+static uint64_t bucket_highest_value(unsigned int index) {
+    if (index < (1u << HDR_SUB_BUCKET_BITS)) {
+        return index;
+    }
+
+    unsigned int shift = (index >> (HDR_SUB_BUCKET_BITS - 1)) - 1;
+    uint64_t mantissa = index - (shift << (HDR_SUB_BUCKET_BITS - 1));
+    return (mantissa << shift) + (UINT64_C(1) << shift) - 1;
+}
+
+static int put_u8(FILE *fp, unsigned int value) {
+    return fputc((int)(value & 0xff), fp) == EOF ? -1 : 0;
+}
+
+static int put_u32(FILE *fp, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        if (put_u8(fp, (value >> (8 * i)) & 0xff) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int put_u64(FILE *fp, uint64_t value) {
+    return put_u32(fp, (uint32_t)value) < 0 || put_u32(fp, (uint32_t)(value >> 32)) < 0 ? -1 : 0;
+}
+
+static int get_u8(FILE *fp, unsigned int *value) {
+    int c = fgetc(fp);
+    if (c == EOF) {
+        return -1;
+    }
+    *value = (unsigned int)c;
+    return 0;
+}
+
+static int get_u32(FILE *fp, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), fp) != sizeof(bytes)) {
+        return -1;
+    }
+    *value = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+             (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    return 0;
+}
+
+static int get_u64(FILE *fp, uint64_t *value) {
+    uint32_t low, high;
+    if (get_u32(fp, &low) < 0 || get_u32(fp, &high) < 0) {
+        return -1;
+    }
+    *value = (uint64_t)high << 32 | low;
+    return 0;
+}
+
+void hdr_histogram_reset(hdr_histogram_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void hdr_histogram_record(hdr_histogram_t *hist, uint64_t value) {
+    if (hist->total == 0 || value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->counts[bucket_index(value)]++;
+    hist->total++;
+}
+
+void hdr_histogram_merge(hdr_histogram_t *dst, const hdr_histogram_t *src) {
+    if (src->total == 0) {
+        return;
+    }
+    if (dst->total == 0 || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+}
+
+uint64_t hdr_histogram_percentile(const hdr_histogram_t *hist, double percentile) {
+    if (hist->total == 0) {
+        return 0;
+    }
+
+    // Rank of the requested value, at least the first one
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)hist->total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_highest_value(i);
+            return value > hist->max ? hist->max : value;
+        }
+    }
+    return hist->max;
+}
+
+void hdr_histogram_print_header(FILE *fp) {
+    fprintf(fp, "%-16s %10s %12s %12s %12s %12s %12s %12s\n",
+            "HISTOGRAM", "COUNT", "MIN", "P50", "P90", "P99", "P99.9", "MAX");
+}
+
+void hdr_histogram_print(const hdr_histogram_t *hist, const char *name, FILE *fp) {
+    if (hist->total == 0) {
+        return;
+    }
+    fprintf(fp, "%-16s %10llu %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+            name, (unsigned long long)hist->total,
+            hist->min / 1000.0,
+            hdr_histogram_percentile(hist, 50.0) / 1000.0,
+            hdr_histogram_percentile(hist, 90.0) / 1000.0,
+            hdr_histogram_percentile(hist, 99.0) / 1000.0,
+            hdr_histogram_percentile(hist, 99.9) / 1000.0,
+            hist->max / 1000.0);
+}
+
+int hdr_histogram_write(FILE *fp, const char *name, const hdr_histogram_t *hist) {
+    size_t name_len = strlen(name);
+    uint32_t nonzero = 0;
+
+    if (name_len >= HDR_NAME_MAX) {
+        name_len = HDR_NAME_MAX - 1;
+    }
+    for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++) {
+        if (hist->counts[i]) {
+            nonzero++;
+        }
+    }
+
+    // Sparse encoding: only non-empty buckets are stored
+    if (fwrite(HDR_BLOB_MAGIC, 1, 4, fp) != 4 ||
+        put_u8(fp, HDR_BLOB_VERSION) < 0 ||
+        put_u8(fp, HDR_SUB_BUCKET_BITS) < 0 ||
+        put_u8(fp, HDR_MAX_VALUE_BITS) < 0 ||
+        put_u8(fp, (unsigned int)name_len) < 0 ||
+        fwrite(name, 1, name_len, fp) != name_len ||
+        put_u64(fp, hist->total) < 0 ||
+        put_u64(fp, hist->min) < 0 ||
+        put_u64(fp, hist->max) < 0 ||
+        put_u32(fp, nonzero) < 0) {
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++) {
+        if (hist->counts[i]) {
+            if (put_u32(fp, i) < 0 || put_u64(fp, hist->counts[i]) < 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int hdr_histogram_read(FILE *fp, char *name, hdr_histogram_t *hist) {
+    char magic[4];
+    unsigned int version, sub_bucket_bits, max_value_bits, name_len;
+    uint32_t nonzero;
+
+    size_t n = fread(magic, 1, sizeof(magic), fp);
+    if (n == 0 && feof(fp)) {
+        return 0;
+    }
+    if (n != sizeof(magic) || memcmp(magic, HDR_BLOB_MAGIC, 4) != 0 ||
+        get_u8(fp, &version) < 0 || version != HDR_BLOB_VERSION ||
+        get_u8(fp, &sub_bucket_bits) < 0 || sub_bucket_bits != HDR_SUB_BUCKET_BITS ||
+        get_u8(fp, &max_value_bits) < 0 || max_value_bits != HDR_MAX_VALUE_BITS ||
+        get_u8(fp, &name_len) < 0 || name_len >= HDR_NAME_MAX ||
+        fread(name, 1, name_len, fp) != name_len) {
+        return -1;
+    }
+    name[name_len] = '\0';
+
+    hdr_histogram_reset(hist);
+    if (get_u64(fp, &hist->total) < 0 || get_u64(fp, &hist->min) < 0 ||
+        get_u64(fp, &hist->max) < 0 || get_u32(fp, &nonzero) < 0) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < nonzero; i++) {
+        uint32_t index;
+        uint64_t count;
+        if (get_u32(fp, &index) < 0 || get_u64(fp, &count) < 0 || index >= HDR_BUCKET_COUNT) {
+            return -1;
+        }
+        hist->counts[index] = count;
+    }
+    return 1;
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "log_parse.h"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+// Parse a fixed number of decimal digits
+static int parse_digits(const char *text, size_t count, long *value) {
+    long result = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return -1;
+        }
+        result = result * 10 + (text[i] - '0');
+    }
+    *value = result;
+    return 0;
+}
+
+// Parse up to six fractional digits as microseconds
+static int parse_fraction(const char *text, size_t len, long *usec) {
+    long result = 0;
+    size_t i;
+
+    if (len == 0 || len > 9) {
+        return -1;
+    }
+    for (i = 0; i < len; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return -1;
+        }
+        if (i < 6) {
+            result = result * 10 + (text[i] - '0');
+        }
+    }
+    for (; i < 6; i++) {
+        result *= 10;
+    }
+    *usec = result;
+    return 0;
+}
+
+void log_parser_init(log_parser_t *parser) {
+    memset(parser, 0, sizeof(*parser));
+}
+
+int log_parse_time(log_parser_t *parser, const char *text, size_t len,
+                   long long *time_us, int *relative) {
+    long year, month, day, hour, minute, second, usec = 0;
+
+    // Absolute: YYYY-MM-DD HH:MM:SS[.uuuuuu]
+    if (len >= 19 && text[4] == '-' && text[7] == '-' && text[10] == ' ' &&
+        text[13] == ':' && text[16] == ':') {
+        if (parse_digits(text, 4, &year) < 0 || parse_digits(text + 5, 2, &month) < 0 ||
+            parse_digits(text + 8, 2, &day) < 0 || parse_digits(text + 11, 2, &hour) < 0 ||
+            parse_digits(text + 14, 2, &minute) < 0 || parse_digits(text + 17, 2, &second) < 0) {
+            return -1;
+        }
+        if (len > 19) {
+            if (text[19] != '.' || parse_fraction(text + 20, len - 20, &usec) < 0) {
+                return -1;
+            }
+        }
+
+        // Local time offsets only change on hour boundaries, cache per hour
+        if (memcmp(parser->cached_hour, text, sizeof(parser->cached_hour)) != 0) {
+            struct tm tm_info;
+            memset(&tm_info, 0, sizeof(tm_info));
+            tm_info.tm_year = (int)year - 1900;
+            tm_info.tm_mon = (int)month - 1;
+            tm_info.tm_mday = (int)day;
+            tm_info.tm_hour = (int)hour;
+            tm_info.tm_isdst = -1;
+
+            time_t epoch = mktime(&tm_info);
+            if (epoch == (time_t)-1) {
+                return -1;
+            }
+            memcpy(parser->cached_hour, text, sizeof(parser->cached_hour));
+            parser->cached_epoch = epoch;
+        }
+
+        *time_us = ((long long)parser->cached_epoch + minute * 60 + second) * 1000000LL + usec;
+        *relative = 0;
+        return 0;
+    }
+
+    // Relative: [-]seconds[.uuuuuu]
+    int negative = len > 0 && text[0] == '-';
+    size_t dot = (size_t)negative;
+    long long seconds = 0;
+    while (dot < len && text[dot] >= '0' && text[dot] <= '9') {
+        seconds = seconds * 10 + (text[dot] - '0');
+        dot++;
+    }
+    if (dot == (size_t)negative) {
+        return -1;
+    }
+    if (dot < len) {
+        if (text[dot] != '.' || parse_fraction(text + dot + 1, len - dot - 1, &usec) < 0) {
+            return -1;
+        }
+    }
+
+    *time_us = negative ? -(seconds * 1000000LL + usec) : seconds * 1000000LL + usec;
+    *relative = 1;
+    return 0;
+}
+
+signal_id_t log_parse_signal(const char *name, size_t len) {
+    if (len != 3) {
+        return SIGNAL_COUNT;
+    }
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (strncasecmp(name, signal_names[i], 3) == 0) {
+            return (signal_id_t)i;
+        }
+    }
+    return SIGNAL_COUNT;
+}
+
+int log_parse_line(log_parser_t *parser, const char *line, size_t len, log_record_t *record) {
+    const char *end = line + len;
+    const char *close;
+
+    if (len < 3 || line[0] != '[') {
+        return -1;
+    }
+
+    close = memchr(line + 1, ']', len - 1);
+    if (!close) {
+        return -1;
+    }
+
+    if (log_parse_time(parser, line + 1, (size_t)(close - line - 1),
+                       &record->time_us, &record->relative) < 0) {
+        return -1;
+    }
+
+    record->is_edge = 0;
+    record->signal = SIGNAL_COUNT;
+    record->state = 0;
+
+    // Edge records: "] SIG: HIGH" or "] SIG: LOW"
+    const char *p = close + 1;
+    if (end - p >= 9 && p[0] == ' ' && p[4] == ':' && p[5] == ' ') {
+        signal_id_t signal = log_parse_signal(p + 1, 3);
+        if (signal != SIGNAL_COUNT) {
+            if (end - p >= 10 && memcmp(p + 6, "HIGH", 4) == 0) {
+                record->state = 1;
+                record->is_edge = 1;
+            } else if (memcmp(p + 6, "LOW", 3) == 0) {
+                record->state = 0;
+                record->is_edge = 1;
+            }
+            if (record->is_edge) {
+                record->signal = signal;
+            }
+        }
+    }
+
+    return 0;
+}
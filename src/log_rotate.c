@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include "log_rotate.h"
+
+// Build the path of the current segment
+static int segment_path(const log_rotate_t *rot, char *buffer, size_t size) {
+    int len = snprintf(buffer, size, "%s.%04u", rot->base_path, rot->segment_number);
+    if (len < 0 || (size_t)len >= size) {
+        fprintf(stderr, "Output segment path too long: %s\n", rot->base_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Open the current segment
+static int open_segment(log_rotate_t *rot) {
+    char path[PATH_MAX];
+    if (segment_path(rot, path, sizeof(path)) < 0) {
+        return -1;
+    }
+
+    rot->fp = fopen(path, "w");
+    if (!rot->fp) {
+        fprintf(stderr, "Error opening output segment %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    segment_stats_reset(&rot->stats);
+    return 0;
+}
+
+// Close the current segment and append it to the index
+static void close_segment(log_rotate_t *rot) {
+    char path[PATH_MAX];
+
+    if (!rot->fp) {
+        return;
+    }
+
+    fclose(rot->fp);
+    rot->fp = NULL;
+
+    if (rot->stats.records && segment_path(rot, path, sizeof(path)) == 0) {
+        segment_index_append(rot->base_path, path, &rot->stats);
+    }
+}
+
+int log_rotate_open(log_rotate_t *rot, const char *base_path,
+                    unsigned long long max_bytes, long period_s) {
+    memset(rot, 0, sizeof(*rot));
+    rot->base_path = base_path;
+    rot->max_bytes = max_bytes;
+    rot->period_s = period_s;
+    rot->period = -1;
+
+    if (segment_index_create(base_path) < 0) {
+        return -1;
+    }
+
+    return open_segment(rot);
+}
+
+FILE *log_rotate_begin(log_rotate_t *rot, const struct timespec *ts) {
+    int rotate = 0;
+
+    if (!rot->fp) {
+        return NULL;
+    }
+
+    if (rot->period_s > 0) {
+        long period = segment_period_number(ts, rot->period_s);
+        if (rot->period >= 0 && period != rot->period) {
+            rotate = 1;
+        }
+        rot->period = period;
+    }
+
+    if (rot->max_bytes > 0 && rot->stats.bytes >= rot->max_bytes) {
+        rotate = 1;
+    }
+
+    if (rotate && rot->stats.records) {
+        close_segment(rot);
+        rot->segment_number++;
+        if (open_segment(rot) < 0) {
+            return NULL;
+        }
+    }
+
+    rot->pending_ts = *ts;
+    return rot->fp;
+}
+
+void log_rotate_end(log_rotate_t *rot, size_t len, int is_edge) {
+    segment_stats_record(&rot->stats, &rot->pending_ts, is_edge, len);
+}
+
+void log_rotate_close(log_rotate_t *rot) {
+    close_segment(rot);
+}
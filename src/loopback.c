@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "loopback.h"
+#include "signal_state.h"
+#include "timestamp.h"
+
+// Driven output and looped-back input of each path
+static const signal_id_t path_outputs[LOOPBACK_PATHS] = { SIGNAL_RTS, SIGNAL_DTR };
+static const signal_id_t path_inputs[LOOPBACK_PATHS] = { SIGNAL_CTS, SIGNAL_DSR };
+static const char *const path_names[LOOPBACK_PATHS] = { "RTS->CTS", "DTR->DSR" };
+
+// Parse one step: line names joined with '+'
+static int parse_step(const char *step, size_t len, int *paths) {
+    *paths = 0;
+    while (len > 0) {
+        size_t name_len = strcspn(step, "+,");
+        if (name_len > len) {
+            name_len = len;
+        }
+        if (name_len == 3 && strncasecmp(step, "RTS", 3) == 0) {
+            *paths |= 1 << LOOPBACK_RTS_CTS;
+        } else if (name_len == 3 && strncasecmp(step, "DTR", 3) == 0) {
+            *paths |= 1 << LOOPBACK_DTR_DSR;
+        } else {
+            return -1;
+        }
+        step += name_len;
+        len -= name_len;
+        if (len > 0) {
+            // Skip the '+' and reject a trailing one
+            step++;
+            len--;
+            if (len == 0) {
+                return -1;
+            }
+        }
+    }
+    return *paths ? 0 : -1;
+}
+
+int loopback_init(loopback_t *lb, const char *pattern, double rate_hz, unsigned long long count,
+                  const signal_state_t *initial, const struct timespec *now) {
+    memset(lb, 0, sizeof(*lb));
+
+    for (const char *step = pattern; ; ) {
+        size_t len = strcspn(step, ",");
+        if (lb->step_count == LOOPBACK_MAX_STEPS ||
+            parse_step(step, len, &lb->steps[lb->step_count]) < 0) {
+            fprintf(stderr, "Invalid loopback pattern: %s\n", pattern);
+            return -1;
+        }
+        lb->step_count++;
+        if (step[len] == '\0') {
+            break;
+        }
+        step += len + 1;
+    }
+
+    if (rate_hz <= 0.0 || rate_hz > 1e6) {
+        fprintf(stderr, "Invalid loopback rate: %g steps/s (allowed: up to 1000000)\n", rate_hz);
+        return -1;
+    }
+    lb->period_ns = (long long)(1e9 / rate_hz + 0.5);
+    lb->count = count;
+    lb->next_due = *now;
+    lb->last_write = *now;
+
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        lb->channels[i].level = signal_state_level(initial, path_outputs[i]);
+        lb->channels[i].echo_level = signal_state_level(initial, path_inputs[i]);
+    }
+    return 0;
+}
+
+int loopback_due(loopback_t *lb, const struct timespec *now, int *set_mask, int *clear_mask) {
+    if ((lb->count && lb->driven >= lb->count) || elapsed_ns(&lb->next_due, now) < 0) {
+        return 0;
+    }
+
+    int paths = lb->steps[lb->next_step];
+    *set_mask = 0;
+    *clear_mask = 0;
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        loopback_channel_t *ch = &lb->channels[i];
+        if (!(paths & (1 << i))) {
+            continue;
+        }
+        if (ch->pending) {
+            ch->pending = 0;
+            ch->lost++;
+        }
+        if (ch->level) {
+            *clear_mask |= 1 << path_outputs[i];
+        } else {
+            *set_mask |= 1 << path_outputs[i];
+        }
+    }
+
+    // Absolute deadlines keep the rate exact; after an overrun (a slow
+    // sample or a long IRQ wait) restart the schedule instead of bursting
+    lb->next_step = (lb->next_step + 1) % lb->step_count;
+    lb->driven++;
+    lb->next_due = add_ns(&lb->next_due, lb->period_ns);
+    if (elapsed_ns(&lb->next_due, now) >= 0) {
+        lb->next_due = add_ns(now, lb->period_ns);
+    }
+    return 1;
+}
+
+void loopback_written(loopback_t *lb, int set_mask, int clear_mask,
+                      const struct timespec *write_time) {
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        loopback_channel_t *ch = &lb->channels[i];
+        int bit = 1 << path_outputs[i];
+        if (!((set_mask | clear_mask) & bit)) {
+            continue;
+        }
+        ch->level = (set_mask & bit) != 0;
+        ch->pending = 1;
+        ch->write_time = *write_time;
+        ch->writes++;
+    }
+    lb->last_write = *write_time;
+}
+
+void loopback_sample(loopback_t *lb, const signal_state_t *state, const struct timespec *ts) {
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        loopback_channel_t *ch = &lb->channels[i];
+        int level = signal_state_level(state, path_inputs[i]);
+        if (level == ch->echo_level) {
+            continue;
+        }
+        ch->echo_level = level;
+
+        if (ch->pending && level == ch->level) {
+            long long latency = elapsed_ns(&ch->write_time, ts);
+            hdr_histogram_record(&ch->latency, latency > 0 ? (uint64_t)latency : 0);
+            ch->pending = 0;
+            ch->echoes++;
+        } else {
+            ch->unexpected++;
+        }
+    }
+}
+
+long long loopback_until_due(const loopback_t *lb, const struct timespec *now) {
+    if (lb->count && lb->driven >= lb->count) {
+        return -1;
+    }
+    long long ns = elapsed_ns(now, &lb->next_due);
+    return ns > 0 ? ns : 0;
+}
+
+int loopback_done(loopback_t *lb, const struct timespec *now) {
+    if (!lb->count || lb->driven < lb->count) {
+        return 0;
+    }
+
+    int pending = 0;
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        pending |= lb->channels[i].pending;
+    }
+    if (pending && elapsed_ns(&lb->last_write, now) < lb->period_ns) {
+        return 0;
+    }
+
+    // The last echoes are given one step period, like all others
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        if (lb->channels[i].pending) {
+            lb->channels[i].pending = 0;
+            lb->channels[i].lost++;
+        }
+    }
+    return 1;
+}
+
+void loopback_path_name(loopback_path_t path, const char *mode, char *buffer, size_t size) {
+    snprintf(buffer, size, "loopback.%s.%s", mode, path_names[path]);
+}
+
+void loopback_print(const loopback_t *lb, const char *mode, FILE *fp) {
+    int used = 0;
+    char name[48];
+
+    for (int i = 0; i < lb->step_count; i++) {
+        used |= lb->steps[i];
+    }
+
+    fprintf(fp, "=== Loopback Round Trip (%s mode, microseconds) ===\n", mode);
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        const loopback_channel_t *ch = &lb->channels[i];
+        if (used & (1 << i)) {
+            fprintf(fp, "%s: writes=%llu echoes=%llu lost=%llu unexpected=%llu\n",
+                    path_names[i], ch->writes, ch->echoes, ch->lost, ch->unexpected);
+        }
+    }
+    hdr_histogram_print_header(fp);
+    for (int i = 0; i < LOOPBACK_PATHS; i++) {
+        if (used & (1 << i)) {
+            loopback_path_name((loopback_path_t)i, mode, name, sizeof(name));
+            hdr_histogram_print(&lb->channels[i].latency, name, fp);
+        }
+    }
+    fflush(fp);
+}
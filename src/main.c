@@ -3,13 +3,27 @@
 #include <unistd.h>
 #include <signal.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <sys/time.h>
 #include "cts_monitor.h"
+#include "trigger.h"
+#include "capture_backend.h"
+#include "generator.h"
+#include "daemon.h"
+#include "signal_state.h"
 
 static volatile int running = 1;
 static volatile int signal_received = 0;
 static volatile int cleanup_done = 0;
+static volatile sig_atomic_t stats_requested = 0;
+static volatile sig_atomic_t reopen_requested = 0;
+static cts_monitor_t *monitor = NULL;
+
+void stats_signal_handler(int sig) {
+    (void)sig;
+    stats_requested = 1;
+}
 
 void signal_handler(int sig) {
     // Prevent multiple executions of signal handler
@@ -24,7 +38,7 @@ void signal_handler(int sig) {
         cleanup_done = 1;  // Set flag immediately
         
         // Call cleanup directly from signal handler
-        cts_monitor_cleanup();
+        cts_monitor_destroy(monitor);
         
         // Exit immediately to prevent infinite signal loops
         printf("CTS Monitor shutdown complete\n");
@@ -32,24 +46,175 @@ void signal_handler(int sig) {
     }
 }
 
+// Stop the main loop and let it shut down normally: pattern playback
+// reports what it achieved, the output thread drains its queue
+void stop_signal_handler(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+// SIGHUP reopens the output file after it was moved by logrotate
+void reopen_signal_handler(int sig) {
+    (void)sig;
+    reopen_requested = 1;
+}
+
+// Play a pattern file on RTS/DTR instead of monitoring
+static int run_generator(const monitor_config_t *config, const char *pattern_file,
+                         unsigned long repeat) {
+    generator_pattern_t pattern;
+    generator_stats_t stats;
+    capture_backend_t backend;
+    FILE *report = stdout;
+    
+    if (generator_load(&pattern, pattern_file) < 0) {
+        return EXIT_FAILURE;
+    }
+    if (capture_backend_open(&backend, config) < 0) {
+        generator_free(&pattern);
+        return EXIT_FAILURE;
+    }
+    if (!backend.ops->set_lines) {
+        fprintf(stderr, "Error: The %s backend cannot drive RTS/DTR\n", backend.ops->name);
+        capture_backend_close(&backend);
+        generator_free(&pattern);
+        return EXIT_FAILURE;
+    }
+    if (config->output_file) {
+        report = fopen(config->output_file, "w");
+        if (!report) {
+            perror("Error opening report file");
+            capture_backend_close(&backend);
+            generator_free(&pattern);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    if (config->verbose) {
+        printf("Generating %zu transitions per pass (%.3f ms) on %s, %lu passes\n",
+               pattern.count, pattern.length_ns / 1e6, config->serial_device, repeat);
+    }
+    
+    struct sigaction sa;
+    sa.sa_handler = stop_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESETHAND;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    
+    int result = generator_run(&pattern, &backend, repeat, report, &running, &stats);
+    
+    if (report != stdout) {
+        fclose(report);
+    }
+    generator_print(&stats, stdout);
+    capture_backend_close(&backend);
+    generator_free(&pattern);
+    return result < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Parse --min-pulse: "US" for all signals or "SIG=US[,SIG=US...]"
+static int parse_min_pulse(const char *arg, long min_pulse_us[SIGNAL_COUNT]) {
+    static const char *const names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+    char *end;
+    
+    if (strchr(arg, '=') == NULL) {
+        long us = strtol(arg, &end, 10);
+        if (end == arg || *end != '\0' || us < 0) {
+            return -1;
+        }
+        for (int i = 0; i < SIGNAL_COUNT; i++) {
+            min_pulse_us[i] = us;
+        }
+        return 0;
+    }
+    
+    while (*arg) {
+        const char *eq = strchr(arg, '=');
+        int signal = SIGNAL_COUNT;
+        if (!eq) {
+            return -1;
+        }
+        for (int i = 0; i < SIGNAL_COUNT; i++) {
+            if ((size_t)(eq - arg) == strlen(names[i]) && strncasecmp(arg, names[i], eq - arg) == 0) {
+                signal = i;
+            }
+        }
+        long us = strtol(eq + 1, &end, 10);
+        if (signal == SIGNAL_COUNT || end == eq + 1 || us < 0 || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        min_pulse_us[signal] = us;
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return 0;
+}
+
 void print_usage(const char* program_name) {
     printf("Usage: %s [options] <serial_device>\n", program_name);
     printf("Options:\n");
     printf("  -h, --help     Show this help message\n");
     printf("  -v, --verbose  Enable verbose output\n");
     printf("  -m MODE        Monitoring mode: poll|irq (default: poll)\n");
+    printf("  --signals LIST Signals to log, e.g. CTS,RTS,DSR or all (default: CTS,RTS; all with -v)\n");
     printf("  -i INTERVAL    Polling interval in microseconds (default: 1000, poll mode only)\n");
     printf("  -f FORMAT      Time format: abs|rel (default: abs)\n");
     printf("  -o FILE        Output file (default: stdout)\n");
+    printf("  -b BACKEND     Output backend: stdio|mmap|none (default: stdio)\n");
+    printf("  --output-format FMT  Output format: text|vcd|pcapng (default: text)\n");
+    printf("  --segment-size MB  Capture segment size for mmap backend (default: 64)\n");
+    printf("  --rotate-size MB   Rotate output file after MB megabytes (stdio backend)\n");
+    printf("  --rotate-interval SEC  Rotate output on wall-clock periods of SEC seconds\n");
+    printf("  --stats        Collect pulse-width/period statistics (printed at exit and on SIGUSR1)\n");
+    printf("  --hist FILE    Record pulse-width and RTS->CTS histograms, saved to FILE at exit\n");
+    printf("  --latency      Measure edge detection and write latency (printed at exit and on SIGUSR1)\n");
+    printf("  --handshake US Analyze RTS->CTS handshakes, flag responses slower than US microseconds\n");
+    printf("  --min-pulse US Suppress pulses shorter than US microseconds (or SIG=US,... per signal)\n");
+    printf("  --trigger EXPR Only write edges around trigger events (see Trigger expressions)\n");
+    printf("  --pre-trigger N    Edges kept in memory before the trigger (default: 10000)\n");
+    printf("  --post-trigger DUR Keep writing edges for DUR after the trigger (default: 1s)\n");
+    printf("  --stream PATH  Serve live edges to subscribers on Unix socket PATH\n");
+    printf("  --stream-queue KB  Per-subscriber queue; slower clients are disconnected (default: 64)\n");
+    printf("  --shm NAME     Publish edges into shared-memory ring NAME (e.g. /cts_monitor)\n");
+    printf("  --shm-slots N  Edge ring size, rounded up to a power of two (default: 65536)\n");
+    printf("  --metrics EP   Serve Prometheus metrics on [127.0.0.1:]PORT or unix:PATH\n");
+    printf("  --control PATH Accept reconfiguration commands on Unix socket PATH (see Control commands)\n");
+    printf("  --speed X      Replay at X times the logged timing, 0 = as fast as possible (default: 1)\n");
+    printf("  --generate FILE    Play the RTS/DTR pattern in FILE instead of monitoring\n");
+    printf("  --repeat N     Pattern passes for --generate, 0 = until stopped (default: 1)\n");
+    printf("  --loopback PAT Drive RTS/DTR and measure round trips over a loopback plug (e.g. RTS,DTR)\n");
+    printf("  --loopback-rate HZ   Loopback pattern steps per second (default: 100)\n");
+    printf("  --loopback-count N   Stop after N loopback steps (default: run until stopped)\n");
+    printf("  -d, --daemon   Run in the background; SIGHUP reopens the output file (requires -o)\n");
+    printf("  --pidfile FILE Write the process ID to FILE and refuse to start twice\n");
+    printf("  --priority N   Capture at SCHED_FIFO priority N (1-99, default with -d: %d)\n",
+           DAEMON_DEFAULT_PRIORITY);
     printf("\n");
     printf("Monitoring Modes:\n");
     printf("  poll           Polling-based monitoring (configurable interval)\n");
     printf("  irq            Event-driven monitoring using select() system call\n");
     printf("\n");
+    printf("Output Backends:\n");
+    printf("  stdio          Buffered stream to stdout or the output file\n");
+    printf("  mmap           Preallocated memory-mapped segments FILE.0000, FILE.0001, ...\n");
+    printf("  none           No records, for --stream, --shm, --metrics or statistics only\n");
+    printf("  Segmented outputs record each closed segment in FILE.idx\n");
+    printf("\nControl commands (one per line, answered with ok or error):\n");
+    printf("  get            Show interval, signals and output\n");
+    printf("  set KEY=VALUE...   Change interval=US, signals=LIST and output=FILE (- for stdout) together\n");
+    printf("  reopen         Reopen the output file\n");
+    printf("\nTrigger expressions (',' separates alternatives):\n");
+    printf("  CTS=LOW        Edge into a level\n");
+    printf("  CTS=LOW>50ms   Level held longer than a duration (us, ms or s)\n");
+    printf("  CTS=HIGH<20us  Pulse shorter than a duration\n");
+    printf("  ...&RTS=HIGH   Only while another signal is at a level\n");
+    printf("\n");
     printf("Serial Device Examples:\n");
     printf("  /dev/ttyUSB0   USB serial adapter (FTDI auto-detected)\n");
     printf("  /dev/ttyS0     Built-in serial port\n");
     printf("  /dev/ttyACM0   USB CDC device\n");
+    printf("  synthetic:RTS=1k,CTS=RTS+100us  Generated signals, no hardware needed\n");
+    printf("  replay:FILE    Edges of a recorded text log\n");
     printf("\n");
 #ifdef HAVE_LIBFTDI1
     printf("CTS Monitor v1.2.0 - Monitor CTS/RTS signals on serial lines\n");
@@ -68,6 +233,35 @@ int main(int argc, char *argv[]) {
     char *output_file = NULL;
     time_format_t time_format = TIME_FORMAT_ABSOLUTE;
     monitor_mode_t monitor_mode = MONITOR_MODE_POLLING;
+    output_backend_t output_backend = OUTPUT_BACKEND_STDIO;
+    output_format_t output_format = OUTPUT_FORMAT_TEXT;
+    size_t segment_size = 0;
+    unsigned long long rotate_size = 0;
+    long rotate_interval = 0;
+    int stats = 0;
+    char *hist_file = NULL;
+    int latency = 0;
+    long handshake_timeout_us = 0;
+    long min_pulse_us[SIGNAL_COUNT] = { 0 };
+    char *trigger = NULL;
+    long pre_trigger_edges = 0;
+    long long post_trigger_ns = 1000000000LL;
+    char *stream_socket = NULL;
+    size_t stream_queue_size = 0;
+    char *shm_name = NULL;
+    long shm_slots = 0;
+    char *metrics_endpoint = NULL;
+    double replay_speed = 1.0;
+    char *loopback = NULL;
+    char *generate_file = NULL;
+    long repeat = 1;
+    double loopback_rate = 100.0;
+    long long loopback_count = 0;
+    int signal_mask = 0;
+    char *control_socket = NULL;
+    int daemonize = 0;
+    char *pidfile = NULL;
+    int priority = 0;
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -97,8 +291,9 @@ int main(int argc, char *argv[]) {
         else if (strcmp(argv[i], "-i") == 0) {
             if (i + 1 < argc) {
                 poll_interval_us = atoi(argv[++i]);
-                if (poll_interval_us < 100) {
-                    fprintf(stderr, "Error: Minimum polling interval is 100 microseconds\n");
+                if (poll_interval_us < CTS_MONITOR_MIN_POLL_INTERVAL_US) {
+                    fprintf(stderr, "Error: Minimum polling interval is %d microseconds\n",
+                            CTS_MONITOR_MIN_POLL_INTERVAL_US);
                     return EXIT_FAILURE;
                 }
             } else {
@@ -130,6 +325,310 @@ int main(int argc, char *argv[]) {
                 return EXIT_FAILURE;
             }
         }
+        else if (strcmp(argv[i], "-b") == 0) {
+            if (i + 1 < argc) {
+                char *backend = argv[++i];
+                if (strcmp(backend, "stdio") == 0) {
+                    output_backend = OUTPUT_BACKEND_STDIO;
+                } else if (strcmp(backend, "mmap") == 0) {
+                    output_backend = OUTPUT_BACKEND_MMAP;
+                } else if (strcmp(backend, "none") == 0) {
+                    output_backend = OUTPUT_BACKEND_NONE;
+                } else {
+                    fprintf(stderr, "Error: Invalid output backend %s (use 'stdio', 'mmap' or 'none')\n", backend);
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: -b option requires a backend (stdio|mmap|none)\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--output-format") == 0) {
+            if (i + 1 < argc) {
+                char *format = argv[++i];
+                if (strcmp(format, "text") == 0) {
+                    output_format = OUTPUT_FORMAT_TEXT;
+                } else if (strcmp(format, "vcd") == 0) {
+                    output_format = OUTPUT_FORMAT_VCD;
+                } else if (strcmp(format, "pcapng") == 0) {
+                    output_format = OUTPUT_FORMAT_PCAPNG;
+                } else {
+                    fprintf(stderr, "Error: Invalid output format %s (use 'text', 'vcd' or 'pcapng')\n", format);
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --output-format option requires a format (text|vcd|pcapng)\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--segment-size") == 0) {
+            if (i + 1 < argc) {
+                int segment_mb = atoi(argv[++i]);
+                if (segment_mb < 1) {
+                    fprintf(stderr, "Error: Minimum segment size is 1 MB\n");
+                    return EXIT_FAILURE;
+                }
+                segment_size = (size_t)segment_mb * 1024 * 1024;
+            } else {
+                fprintf(stderr, "Error: --segment-size option requires a size in MB\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--rotate-size") == 0) {
+            if (i + 1 < argc) {
+                int rotate_mb = atoi(argv[++i]);
+                if (rotate_mb < 1) {
+                    fprintf(stderr, "Error: Minimum rotation size is 1 MB\n");
+                    return EXIT_FAILURE;
+                }
+                rotate_size = (unsigned long long)rotate_mb * 1024 * 1024;
+            } else {
+                fprintf(stderr, "Error: --rotate-size option requires a size in MB\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--rotate-interval") == 0) {
+            if (i + 1 < argc) {
+                rotate_interval = atol(argv[++i]);
+                if (rotate_interval < 1) {
+                    fprintf(stderr, "Error: Minimum rotation interval is 1 second\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --rotate-interval option requires a period in seconds\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+        }
+        else if (strcmp(argv[i], "--latency") == 0) {
+            latency = 1;
+        }
+        else if (strcmp(argv[i], "--hist") == 0) {
+            if (i + 1 < argc) {
+                hist_file = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --hist option requires an output file\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--handshake") == 0) {
+            if (i + 1 < argc) {
+                handshake_timeout_us = atol(argv[++i]);
+                if (handshake_timeout_us < 1) {
+                    fprintf(stderr, "Error: Handshake timeout must be at least 1 microsecond\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --handshake option requires a timeout in microseconds\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--min-pulse") == 0) {
+            if (i + 1 < argc) {
+                if (parse_min_pulse(argv[++i], min_pulse_us) < 0) {
+                    fprintf(stderr, "Error: Invalid minimum pulse width %s (use US or SIG=US,...)\n", argv[i]);
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --min-pulse option requires a width in microseconds\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--trigger") == 0) {
+            if (i + 1 < argc) {
+                trigger = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --trigger option requires an expression\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--pre-trigger") == 0) {
+            if (i + 1 < argc) {
+                pre_trigger_edges = atol(argv[++i]);
+                if (pre_trigger_edges < 1) {
+                    fprintf(stderr, "Error: Pre-trigger buffer must hold at least 1 edge\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --pre-trigger option requires a number of edges\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--post-trigger") == 0) {
+            if (i + 1 < argc) {
+                if (trigger_parse_duration(argv[++i], &post_trigger_ns) < 0) {
+                    fprintf(stderr, "Error: Invalid post-trigger duration %s\n", argv[i]);
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --post-trigger option requires a duration\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--stream") == 0) {
+            if (i + 1 < argc) {
+                stream_socket = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --stream option requires a socket path\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--stream-queue") == 0) {
+            if (i + 1 < argc) {
+                int queue_kb = atoi(argv[++i]);
+                if (queue_kb < 1) {
+                    fprintf(stderr, "Error: Minimum stream queue size is 1 KB\n");
+                    return EXIT_FAILURE;
+                }
+                stream_queue_size = (size_t)queue_kb * 1024;
+            } else {
+                fprintf(stderr, "Error: --stream-queue option requires a size in KB\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--shm") == 0) {
+            if (i + 1 < argc) {
+                shm_name = argv[++i];
+                if (shm_name[0] != '/' || strchr(shm_name + 1, '/') != NULL) {
+                    fprintf(stderr, "Error: Shared-memory name must look like /name\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --shm option requires a name\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--shm-slots") == 0) {
+            if (i + 1 < argc) {
+                shm_slots = atol(argv[++i]);
+                if (shm_slots < 2) {
+                    fprintf(stderr, "Error: Edge ring needs at least 2 slots\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --shm-slots option requires a number of slots\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--speed") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                replay_speed = strtod(argv[++i], &end);
+                if (end == argv[i] || *end != '\0' || replay_speed < 0) {
+                    fprintf(stderr, "Error: Replay speed must be a number >= 0\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --speed option requires a factor\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--generate") == 0) {
+            if (i + 1 < argc) {
+                generate_file = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --generate option requires a pattern file\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--repeat") == 0) {
+            if (i + 1 < argc) {
+                repeat = atol(argv[++i]);
+                if (repeat < 0) {
+                    fprintf(stderr, "Error: Repeat count must be 0 or more\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --repeat option requires a number of passes\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--loopback") == 0) {
+            if (i + 1 < argc) {
+                loopback = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --loopback option requires a pattern\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--loopback-rate") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                loopback_rate = strtod(argv[++i], &end);
+                if (end == argv[i] || *end != '\0' || loopback_rate <= 0 || loopback_rate > 1e6) {
+                    fprintf(stderr, "Error: Loopback rate must be between 0 and 1000000 steps/s\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --loopback-rate option requires a rate\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--loopback-count") == 0) {
+            if (i + 1 < argc) {
+                loopback_count = atoll(argv[++i]);
+                if (loopback_count < 1) {
+                    fprintf(stderr, "Error: Loopback count must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --loopback-count option requires a number of steps\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 < argc) {
+                metrics_endpoint = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --metrics option requires [127.0.0.1:]PORT or unix:PATH\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--signals") == 0) {
+            if (i + 1 < argc) {
+                signal_mask = signal_state_parse_mask(argv[++i]);
+                if (signal_mask < 0) {
+                    fprintf(stderr, "Error: Signals must be a list of CTS, RTS, DSR and DTR, or all\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --signals option requires a signal list\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--control") == 0) {
+            if (i + 1 < argc) {
+                control_socket = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --control option requires a socket path\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--daemon") == 0) {
+            daemonize = 1;
+        }
+        else if (strcmp(argv[i], "--pidfile") == 0) {
+            if (i + 1 < argc) {
+                pidfile = argv[++i];
+            } else {
+                fprintf(stderr, "Error: --pidfile option requires a file name\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--priority") == 0) {
+            if (i + 1 < argc) {
+                priority = atoi(argv[++i]);
+                if (priority < 1 || priority > 99) {
+                    fprintf(stderr, "Error: Priority must be between 1 and 99\n");
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: --priority option requires a priority\n");
+                return EXIT_FAILURE;
+            }
+        }
         else if (argv[i][0] != '-') {
             // This should be the serial device
             if (serial_device == NULL) {
@@ -153,11 +652,76 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
     
-    // Set up signal handlers with sigaction for more reliable handling
+    if (generate_file && (daemonize || pidfile || priority)) {
+        fprintf(stderr, "Error: --generate cannot run as a daemon\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (generate_file) {
+        monitor_config_t config = {
+            .serial_device = serial_device,
+            .output_file = output_file,
+            .verbose = verbose
+        };
+        return run_generator(&config, generate_file, (unsigned long)repeat);
+    }
+    
+    // Replayed logs are paced by their own timestamps, not by polling
+    if (strncmp(serial_device, "replay:", 7) == 0) {
+        monitor_mode = MONITOR_MODE_IRQ;
+    }
+    
+    if (output_backend == OUTPUT_BACKEND_MMAP && output_file == NULL) {
+        fprintf(stderr, "Error: The mmap output backend requires an output file (-o)\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (output_format == OUTPUT_FORMAT_PCAPNG && output_file == NULL) {
+        fprintf(stderr, "Error: PCAP-NG output requires an output file (-o)\n");
+        return EXIT_FAILURE;
+    }
+    
+    if ((rotate_size > 0 || rotate_interval > 0) && output_file == NULL) {
+        fprintf(stderr, "Error: Log rotation requires an output file (-o)\n");
+        return EXIT_FAILURE;
+    }
+    
+    // Only a single file gets the VCD header and time origin
+    if (output_format == OUTPUT_FORMAT_VCD &&
+        (rotate_size > 0 || rotate_interval > 0 || output_backend == OUTPUT_BACKEND_MMAP)) {
+        fprintf(stderr, "Error: VCD output cannot be rotated or written with -b mmap\n");
+        return EXIT_FAILURE;
+    }
+    
+    // Later segments would lack the section header and interface blocks
+    if (output_format == OUTPUT_FORMAT_PCAPNG &&
+        (rotate_size > 0 || rotate_interval > 0 || output_backend == OUTPUT_BACKEND_MMAP)) {
+        fprintf(stderr, "Error: PCAP-NG output cannot be rotated or written with -b mmap\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (daemonize && output_file == NULL && output_backend != OUTPUT_BACKEND_NONE) {
+        fprintf(stderr, "Error: Daemon mode requires an output file (-o) or -b none\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (daemonize && priority == 0) {
+        priority = DAEMON_DEFAULT_PRIORITY;
+    }
+    
+    // Capture at raised priority hands formatting and writing to a
+    // normal-priority thread, so slow output never delays a sample
+    int output_thread = priority > 0 && output_backend != OUTPUT_BACKEND_NONE;
+    
+    // Set up signal handlers with sigaction for more reliable handling.
+    // With an output thread or a pidfile the loop exits and shuts down
+    // normally, so queued records are written and the pidfile removed;
+    // the handler stays installed so a repeated signal cannot cut that short.
+    int graceful_stop = output_thread || daemonize || pidfile;
     struct sigaction sa;
-    sa.sa_handler = signal_handler;
+    sa.sa_handler = graceful_stop ? stop_signal_handler : signal_handler;
     sigemptyset(&sa.sa_mask);
-    sa.sa_flags = SA_RESETHAND;  // Reset to default after first signal
+    sa.sa_flags = graceful_stop ? 0 : SA_RESETHAND;  // Reset to default after first signal
     
     if (sigaction(SIGINT, &sa, NULL) != 0) {
         perror("sigaction SIGINT");
@@ -169,6 +733,32 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
     
+    // SIGUSR1 prints statistics on demand. SA_RESTART resumes interrupted reads and
+    // writes, but Linux never restarts select() or usleep(): the wait backends
+    // report EINTR as a timeout and the polling loop just samples early.
+    struct sigaction sa_stats;
+    sa_stats.sa_handler = stats_signal_handler;
+    sigemptyset(&sa_stats.sa_mask);
+    sa_stats.sa_flags = SA_RESTART;
+    
+    struct sigaction sa_reopen;
+    sa_reopen.sa_handler = reopen_signal_handler;
+    sigemptyset(&sa_reopen.sa_mask);
+    sa_reopen.sa_flags = SA_RESTART;
+    
+    // Without a file to reopen, a hangup still ends an attached process
+    if (((output_file && output_backend == OUTPUT_BACKEND_STDIO) || daemonize) &&
+        sigaction(SIGHUP, &sa_reopen, NULL) != 0) {
+        perror("sigaction SIGHUP");
+        return EXIT_FAILURE;
+    }
+    
+    // Always caught, so a stray SIGUSR1 never kills a capture
+    if (sigaction(SIGUSR1, &sa_stats, NULL) != 0) {
+        perror("sigaction SIGUSR1");
+        return EXIT_FAILURE;
+    }
+    
     // Initialize monitor
     monitor_config_t config = {
         .serial_device = serial_device,
@@ -177,14 +767,58 @@ int main(int argc, char *argv[]) {
         .output_file = output_file,
         .verbose = verbose,
         .mode = monitor_mode,
-        .device_type = DEVICE_TYPE_STANDARD  // Auto-detected during init
+        .device_type = DEVICE_TYPE_STANDARD,  // Auto-detected during init
+        .output_backend = output_backend,
+        .output_format = output_format,
+        .segment_size = segment_size,
+        .rotate_size = rotate_size,
+        .rotate_interval = rotate_interval,
+        .stats = stats,
+        .hist_file = hist_file,
+        .latency = latency,
+        .handshake = handshake_timeout_us > 0,
+        .handshake_timeout_us = handshake_timeout_us,
+        .trigger = trigger,
+        .pre_trigger_edges = (size_t)pre_trigger_edges,
+        .post_trigger_ns = post_trigger_ns,
+        .stream_socket = stream_socket,
+        .stream_queue_size = stream_queue_size,
+        .shm_name = shm_name,
+        .shm_slots = (size_t)shm_slots,
+        .replay_speed = replay_speed,
+        .metrics_endpoint = metrics_endpoint,
+        .loopback = loopback,
+        .loopback_rate = loopback_rate,
+        .loopback_count = (unsigned long long)loopback_count,
+        .output_thread = output_thread,
+        .signal_mask = signal_mask,
+        .control_socket = control_socket
     };
+    memcpy(config.min_pulse_us, min_pulse_us, sizeof(config.min_pulse_us));
     
-    if (cts_monitor_init(&config) != 0) {
+    // Detach first, so the pidfile and every thread belong to the daemon
+    daemon_t daemon = { .ready_fd = -1, .pid_fd = -1, .pidfile = NULL };
+    if (daemonize && daemon_detach(&daemon) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (pidfile && daemon_write_pidfile(&daemon, pidfile) != 0) {
+        daemon_ready(&daemon, 0);
+        return EXIT_FAILURE;
+    }
+    
+    monitor = cts_monitor_create(&config);
+    if (!monitor) {
         fprintf(stderr, "Failed to initialize CTS monitor\n");
+        daemon_cleanup(&daemon);
+        daemon_ready(&daemon, 0);
         return EXIT_FAILURE;
     }
     
+    // Only the calling thread is raised; the output thread already runs
+    if (priority > 0) {
+        daemon_raise_priority(priority);
+    }
+    
     if (verbose) {
         printf("CTS Monitor v1.2.0 starting...\n");
         printf("Serial device: %s\n", serial_device);
@@ -194,6 +828,35 @@ int main(int argc, char *argv[]) {
         }
         printf("Time format: %s\n", time_format == TIME_FORMAT_ABSOLUTE ? "absolute" : "relative");
         printf("Output: %s\n", output_file ? output_file : "stdout");
+        printf("Output backend: %s\n", output_backend == OUTPUT_BACKEND_MMAP ? "mmap" :
+               output_backend == OUTPUT_BACKEND_NONE ? "none" : "stdio");
+        printf("Output format: %s\n", output_format == OUTPUT_FORMAT_VCD ? "vcd" :
+               output_format == OUTPUT_FORMAT_PCAPNG ? "pcapng" : "text");
+        if (rotate_size > 0) {
+            printf("Rotate size: %llu MB\n", rotate_size / (1024 * 1024));
+        }
+        if (rotate_interval > 0) {
+            printf("Rotate interval: %ld seconds\n", rotate_interval);
+        }
+        if (stream_socket) {
+            printf("Stream socket: %s\n", stream_socket);
+        }
+        if (shm_name) {
+            printf("Shared-memory ring: %s\n", shm_name);
+        }
+        if (metrics_endpoint) {
+            printf("Metrics endpoint: %s\n", metrics_endpoint);
+        }
+        if (control_socket) {
+            printf("Control socket: %s\n", control_socket);
+        }
+        if (loopback) {
+            printf("Loopback: %s at %g steps/s\n", loopback, loopback_rate);
+        }
+        if (trigger) {
+            printf("Trigger: %s (%ld edges before, %lld us after)\n", trigger,
+                   pre_trigger_edges ? pre_trigger_edges : TRIGGER_DEFAULT_EDGES, post_trigger_ns / 1000);
+        }
 #ifdef HAVE_LIBFTDI1
         printf("FTDI support: Available\n");
 #endif
@@ -203,26 +866,43 @@ int main(int argc, char *argv[]) {
     
     // Start IRQ mode if configured
     if (monitor_mode == MONITOR_MODE_IRQ) {
-        if (cts_monitor_start_irq() != 0) {
+        if (cts_monitor_start_irq(monitor) != 0) {
             fprintf(stderr, "Failed to start IRQ-driven monitoring\n");
-            cts_monitor_cleanup();
+            cleanup_done = 1;
+            cts_monitor_destroy(monitor);
+            daemon_cleanup(&daemon);
+            daemon_ready(&daemon, 0);
             return EXIT_FAILURE;
         }
     }
     
+    daemon_ready(&daemon, 1);
+    
     // Main monitoring loop
-    while (running) {
+    while (running && !cts_monitor_finished(monitor)) {
+        if (stats_requested) {
+            stats_requested = 0;
+            cts_monitor_print_stats(monitor, stdout);
+        }
+        
+        if (reopen_requested) {
+            reopen_requested = 0;
+            cts_monitor_reopen_output(monitor);
+        }
+        
         if (monitor_mode == MONITOR_MODE_POLLING) {
             // Polling mode: regular updates
-            if (cts_monitor_update() != 0) {
+            if (cts_monitor_update(monitor) != 0) {
                 fprintf(stderr, "Monitor update failed\n");
                 break;
             }
-            // Sleep for specified interval
-            usleep(poll_interval_us);
+            // Sleep for the interval in effect; the control socket may change it
+            cts_monitor_settings_t settings;
+            cts_monitor_get_settings(monitor, &settings);
+            usleep(settings.poll_interval_us);
         } else {
             // IRQ mode: event-driven monitoring with select()
-            int events = cts_monitor_process_irq_events();
+            int events = cts_monitor_process_irq_events(monitor);
             if (events < 0) {
                 fprintf(stderr, "IRQ event processing failed\n");
                 break;
@@ -231,10 +911,13 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    // Cleanup - only if not already done in signal handler
+    // Cleanup - only if not already done in signal handler; a signal
+    // arriving from here on exits instead of cleaning up a second time
     if (!signal_received) {
-        cts_monitor_cleanup();
+        cleanup_done = 1;
+        cts_monitor_destroy(monitor);
     }
+    daemon_cleanup(&daemon);
     
     if (verbose) {
         printf("\nCTS Monitor shutdown complete\n");
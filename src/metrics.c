@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "metrics.h"
+#include "timestamp.h"
+#include "unix_socket.h"
+
+// Requests that do not complete within this time are dropped
+#define METRICS_REQUEST_TIMEOUT_NS 2000000000LL
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+void metrics_init(monitor_metrics_t *metrics, const struct timespec *start) {
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->start_time = *start;
+    hdr_histogram_reset(&metrics->sample_interval);
+}
+
+void metrics_sample(monitor_metrics_t *metrics, const struct timespec *ts) {
+    if (metrics->samples.value > 0) {
+        long long interval = elapsed_ns(&metrics->last_sample, ts);
+        if (interval >= 0) {
+            hdr_histogram_record(&metrics->sample_interval, (uint64_t)interval);
+            metrics->interval_sum_ns.value += (uint64_t)interval;
+        }
+    }
+    metrics->last_sample = *ts;
+    metrics->samples.value++;
+}
+
+void metrics_output_lag(monitor_metrics_t *metrics, const struct timespec *edge_time,
+                        const struct timespec *now) {
+    long long lag = elapsed_ns(edge_time, now);
+    if (lag < 0) {
+        lag = 0;
+    }
+    metrics->output_lag_ns.value = (uint64_t)lag;
+    if ((uint64_t)lag > metrics->output_lag_max_ns.value) {
+        metrics->output_lag_max_ns.value = (uint64_t)lag;
+    }
+}
+
+size_t metrics_format(const monitor_metrics_t *metrics, char *buffer, size_t size) {
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    size_t len = 0;
+
+// Append to the buffer, stopping quietly once it is full
+#define APPEND(...) do { \
+        if (len < size) { \
+            int n = snprintf(buffer + len, size - len, __VA_ARGS__); \
+            len += n > 0 ? (size_t)n : 0; \
+        } \
+    } while (0)
+
+    APPEND("# HELP cts_monitor_start_time_seconds Time the monitor started.\n");
+    APPEND("# TYPE cts_monitor_start_time_seconds gauge\n");
+    APPEND("cts_monitor_start_time_seconds %ld.%09ld\n",
+           (long)metrics->start_time.tv_sec, metrics->start_time.tv_nsec);
+
+    APPEND("# HELP cts_monitor_samples_total Signal state samples taken.\n");
+    APPEND("# TYPE cts_monitor_samples_total counter\n");
+    APPEND("cts_monitor_samples_total %llu\n", (unsigned long long)metrics->samples.value);
+
+    APPEND("# HELP cts_monitor_edges_total Signal edges detected.\n");
+    APPEND("# TYPE cts_monitor_edges_total counter\n");
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        APPEND("cts_monitor_edges_total{signal=\"%s\"} %llu\n", signal_names[i],
+               (unsigned long long)metrics->edges[i].value);
+    }
+
+    APPEND("# HELP cts_monitor_read_errors_total Failed modem-status reads.\n");
+    APPEND("# TYPE cts_monitor_read_errors_total counter\n");
+    APPEND("cts_monitor_read_errors_total %llu\n", (unsigned long long)metrics->read_errors.value);
+
+    APPEND("# HELP cts_monitor_sample_interval_seconds Time between consecutive samples.\n");
+    APPEND("# TYPE cts_monitor_sample_interval_seconds summary\n");
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        uint64_t value = metrics->sample_interval.total
+                         ? hdr_histogram_percentile(&metrics->sample_interval, quantiles[i] * 100.0) : 0;
+        APPEND("cts_monitor_sample_interval_seconds{quantile=\"%g\"} %.9f\n", quantiles[i], value / 1e9);
+    }
+    APPEND("cts_monitor_sample_interval_seconds_sum %.9f\n", metrics->interval_sum_ns.value / 1e9);
+    APPEND("cts_monitor_sample_interval_seconds_count %llu\n",
+           (unsigned long long)metrics->sample_interval.total);
+
+    APPEND("# HELP cts_monitor_output_lag_seconds Delay between the last edge and its output record.\n");
+    APPEND("# TYPE cts_monitor_output_lag_seconds gauge\n");
+    APPEND("cts_monitor_output_lag_seconds %.9f\n", metrics->output_lag_ns.value / 1e9);
+    APPEND("# HELP cts_monitor_output_lag_max_seconds Largest delay between an edge and its output record.\n");
+    APPEND("# TYPE cts_monitor_output_lag_max_seconds gauge\n");
+    APPEND("cts_monitor_output_lag_max_seconds %.9f\n", metrics->output_lag_max_ns.value / 1e9);
+
+    APPEND("# HELP cts_monitor_output_bytes_total Bytes written to the output.\n");
+    APPEND("# TYPE cts_monitor_output_bytes_total counter\n");
+    APPEND("cts_monitor_output_bytes_total %llu\n", (unsigned long long)metrics->bytes_written.value);
+
+#undef APPEND
+    return len < size ? len : size - 1;
+}
+
+int metrics_server_open(metrics_server_t *server, const char *endpoint) {
+    memset(server, 0, sizeof(*server));
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+    }
+
+    if (strncmp(endpoint, "unix:", 5) == 0) {
+        const char *path = endpoint + 5;
+        // unix_path is as long as sun_path, which unix_socket_listen checks
+        server->listen_fd = unix_socket_listen(path, METRICS_MAX_CLIENTS, "metrics");
+        if (server->listen_fd < 0) {
+            return -1;
+        }
+        strcpy(server->unix_path, path);
+        return 0;
+    }
+
+    struct sockaddr_in addr;
+    char *end;
+    // The loopback address may be spelled out; no other address is served
+    const char *port_text = strncmp(endpoint, "127.0.0.1:", 10) == 0 ? endpoint + 10 : endpoint;
+    long port = strtol(port_text, &end, 10);
+    if (end == port_text || *end != '\0' || port < 1 || port > 65535) {
+        fprintf(stderr, "Invalid metrics endpoint %s (use [127.0.0.1:]PORT or unix:PATH)\n", endpoint);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listen_fd >= 0) {
+        int reuse = 1;
+        setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            close(server->listen_fd);
+            server->listen_fd = -1;
+        }
+    }
+
+    if (server->listen_fd < 0 || listen(server->listen_fd, METRICS_MAX_CLIENTS) < 0) {
+        fprintf(stderr, "Error listening for metrics on %s: %s\n", endpoint, strerror(errno));
+        if (server->listen_fd >= 0) {
+            close(server->listen_fd);
+            server->listen_fd = -1;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+static void close_client(metrics_client_t *client) {
+    close(client->fd);
+    client->fd = -1;
+    client->request_len = 0;
+}
+
+static void respond(metrics_server_t *server, metrics_client_t *client,
+                    const monitor_metrics_t *metrics) {
+    char header[128];
+
+    size_t body_len = metrics_format(metrics, server->body, sizeof(server->body));
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %zu\r\n\r\n", body_len);
+
+    // The response fits the socket buffer; a client that cannot take it is dropped
+    if (send(client->fd, header, (size_t)header_len, MSG_DONTWAIT | MSG_NOSIGNAL) == header_len) {
+        send(client->fd, server->body, body_len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    close_client(client);
+}
+
+void metrics_server_service(metrics_server_t *server, const monitor_metrics_t *metrics,
+                            const struct timespec *now) {
+    int fd;
+
+    while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        metrics_client_t *client = NULL;
+        for (int i = 0; i < METRICS_MAX_CLIENTS && !client; i++) {
+            if (server->clients[i].fd < 0) {
+                client = &server->clients[i];
+            }
+        }
+        if (!client) {
+            close(fd);
+            continue;
+        }
+        client->fd = fd;
+        client->request_len = 0;
+        client->opened = *now;
+    }
+
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        metrics_client_t *client = &server->clients[i];
+        if (client->fd < 0) {
+            continue;
+        }
+
+        // Read the whole request so closing the socket does not reset it
+        for (;;) {
+            if (client->request_len == sizeof(client->request) - 1) {
+                // Keep only the tail, where the end of the headers will appear
+                memmove(client->request, client->request + client->request_len - 3, 3);
+                client->request_len = 3;
+            }
+            ssize_t n = recv(client->fd, client->request + client->request_len,
+                             sizeof(client->request) - 1 - client->request_len, MSG_DONTWAIT);
+            if (n <= 0) {
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    close_client(client);
+                }
+                break;
+            }
+            client->request_len += (size_t)n;
+        }
+        if (client->fd < 0) {
+            continue;
+        }
+
+        client->request[client->request_len] = '\0';
+        if (strstr(client->request, "\r\n\r\n") || strstr(client->request, "\n\n")) {
+            respond(server, client, metrics);
+        } else if (elapsed_ns(&client->opened, now) > METRICS_REQUEST_TIMEOUT_NS) {
+            close_client(client);
+        }
+    }
+}
+
+void metrics_server_close(metrics_server_t *server) {
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (server->clients[i].fd >= 0) {
+            close_client(&server->clients[i]);
+        }
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        if (server->unix_path[0]) {
+            unlink(server->unix_path);
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "mmap_capture.h"
+
+// Build the path of the current segment
+static int segment_path(const mmap_capture_t *cap, char *buffer, size_t size) {
+    int len = snprintf(buffer, size, "%s.%04u", cap->base_path, cap->segment_number);
+    if (len < 0 || (size_t)len >= size) {
+        fprintf(stderr, "Capture segment path too long: %s\n", cap->base_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Milliseconds elapsed between two timestamps
+static long elapsed_ms(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000L + (to->tv_nsec - from->tv_nsec) / 1000000L;
+}
+
+// Create, preallocate and map a new segment
+static int open_segment(mmap_capture_t *cap) {
+    char path[PATH_MAX];
+    if (segment_path(cap, path, sizeof(path)) < 0) {
+        return -1;
+    }
+
+    cap->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (cap->fd < 0) {
+        fprintf(stderr, "Error opening capture segment %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    // Preallocate blocks so appends never hit ENOSPC through a page fault
+    if (fallocate(cap->fd, 0, 0, (off_t)cap->segment_size) < 0) {
+        if (errno != EOPNOTSUPP || ftruncate(cap->fd, (off_t)cap->segment_size) < 0) {
+            fprintf(stderr, "Error preallocating capture segment %s: %s\n", path, strerror(errno));
+            close(cap->fd);
+            cap->fd = -1;
+            return -1;
+        }
+    }
+
+    cap->map = mmap(NULL, cap->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, cap->fd, 0);
+    if (cap->map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping capture segment %s: %s\n", path, strerror(errno));
+        cap->map = NULL;
+        close(cap->fd);
+        cap->fd = -1;
+        return -1;
+    }
+
+    madvise(cap->map, cap->segment_size, MADV_SEQUENTIAL);
+
+    cap->used = 0;
+    cap->synced = 0;
+    segment_stats_reset(&cap->stats);
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &cap->last_sync);
+
+    return 0;
+}
+
+// Unmap the current segment, cut it down to the bytes actually written
+// and append it to the index
+static void close_segment(mmap_capture_t *cap) {
+    char path[PATH_MAX];
+    
+    if (cap->map) {
+        msync(cap->map, cap->segment_size, MS_SYNC);
+        munmap(cap->map, cap->segment_size);
+        cap->map = NULL;
+    }
+
+    if (cap->fd >= 0) {
+        if (ftruncate(cap->fd, (off_t)cap->used) < 0) {
+            fprintf(stderr, "Error truncating capture segment: %s\n", strerror(errno));
+        }
+        close(cap->fd);
+        cap->fd = -1;
+
+        if (cap->stats.records && segment_path(cap, path, sizeof(path)) == 0) {
+            segment_index_append(cap->base_path, path, &cap->stats);
+        }
+    }
+}
+
+// Schedule write-back of everything committed since the last sync
+static void sync_pending(mmap_capture_t *cap, const struct timespec *now) {
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t start = cap->synced & ~((size_t)page_size - 1);
+
+    msync(cap->map + start, cap->used - start, MS_ASYNC);
+    cap->synced = cap->used;
+    cap->last_sync = *now;
+}
+
+int mmap_capture_open(mmap_capture_t *cap, const char *base_path, size_t segment_size,
+                      long period_s) {
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    memset(cap, 0, sizeof(*cap));
+    cap->fd = -1;
+    cap->base_path = base_path;
+    cap->segment_size = segment_size ? segment_size : MMAP_CAPTURE_DEFAULT_SEGMENT_SIZE;
+    cap->period_s = period_s;
+    cap->period = -1;
+
+    // Round up to a whole number of pages
+    cap->segment_size = (cap->segment_size + (size_t)page_size - 1) & ~((size_t)page_size - 1);
+
+    if (segment_index_create(base_path) < 0) {
+        return -1;
+    }
+
+    return open_segment(cap);
+}
+
+char *mmap_capture_reserve(mmap_capture_t *cap, size_t max_len, const struct timespec *ts) {
+    int roll = 0;
+
+    if (!cap->map || max_len > cap->segment_size) {
+        return NULL;
+    }
+
+    if (cap->period_s > 0) {
+        long period = segment_period_number(ts, cap->period_s);
+        if (cap->period >= 0 && period != cap->period && cap->stats.records) {
+            roll = 1;
+        }
+        cap->period = period;
+    }
+
+    if (roll || cap->used + max_len > cap->segment_size) {
+        if (mmap_capture_roll(cap) < 0) {
+            return NULL;
+        }
+    }
+
+    cap->pending_ts = *ts;
+    return cap->map + cap->used;
+}
+
+void mmap_capture_commit(mmap_capture_t *cap, size_t len, int is_edge) {
+    cap->used += len;
+    segment_stats_record(&cap->stats, &cap->pending_ts, is_edge, len);
+
+    // Coarse clock is a vDSO read, cheap enough for every record
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+    if (cap->used - cap->synced >= MMAP_CAPTURE_SYNC_BYTES ||
+        elapsed_ms(&cap->last_sync, &now) >= MMAP_CAPTURE_SYNC_INTERVAL_MS) {
+        sync_pending(cap, &now);
+    }
+}
+
+int mmap_capture_roll(mmap_capture_t *cap) {
+    close_segment(cap);
+    cap->segment_number++;
+    return open_segment(cap);
+}
+
+void mmap_capture_close(mmap_capture_t *cap) {
+    close_segment(cap);
+}
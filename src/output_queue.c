@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "output_queue.h"
+
+int output_queue_init(output_queue_t *queue, size_t slots) {
+    size_t count = 1;
+
+    memset(queue, 0, sizeof(*queue));
+    if (slots == 0) {
+        slots = OUTPUT_QUEUE_DEFAULT_SLOTS;
+    }
+    while (count < slots) {
+        count <<= 1;
+    }
+
+    queue->records = malloc(count * sizeof(*queue->records));
+    if (!queue->records) {
+        fprintf(stderr, "Out of memory allocating %zu-record output queue\n", count);
+        return -1;
+    }
+    queue->mask = count - 1;
+    return 0;
+}
+
+void output_queue_free(output_queue_t *queue) {
+    free(queue->records);
+    queue->records = NULL;
+}
+
+output_queue_record_t *output_queue_reserve(output_queue_t *queue) {
+    // Only reload the consumer position when the cached one says full
+    if (queue->head - queue->tail_cache > queue->mask) {
+        queue->tail_cache = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        if (queue->head - queue->tail_cache > queue->mask) {
+            queue->dropped++;
+            return NULL;
+        }
+    }
+    return &queue->records[queue->head & queue->mask];
+}
+
+void output_queue_commit(output_queue_t *queue) {
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+}
+
+const output_queue_record_t *output_queue_peek(output_queue_t *queue) {
+    size_t tail = queue->tail;
+
+    if (tail == __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &queue->records[tail & queue->mask];
+}
+
+void output_queue_release(output_queue_t *queue) {
+    __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,138 @@
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "pcapng_writer.h"
+
+// Block types
+#define BLOCK_SECTION_HEADER 0x0A0D0D0Au
+#define BLOCK_INTERFACE 0x00000001u
+#define BLOCK_ENHANCED_PACKET 0x00000006u
+
+// Option codes
+#define OPT_END 0
+#define OPT_COMMENT 1
+#define OPT_SHB_USERAPPL 4
+#define OPT_IF_NAME 2
+#define OPT_IF_TSRESOL 9
+
+// Block under construction; everything is padded to 32 bits
+typedef struct {
+    unsigned char *start;
+    size_t size;
+    size_t len;
+    int overflow;
+} block_t;
+
+static void put(block_t *b, const void *data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (b->overflow || b->len + len > b->size) {
+        b->overflow = 1;
+        return;
+    }
+    memcpy(b->start + b->len, data, len);
+    b->len += len;
+}
+
+static void put32(block_t *b, uint32_t value) {
+    put(b, &value, sizeof(value));
+}
+
+static void put16(block_t *b, uint16_t value) {
+    put(b, &value, sizeof(value));
+}
+
+static void pad(block_t *b) {
+    static const unsigned char zeros[3] = { 0 };
+    put(b, zeros, (4 - b->len % 4) % 4);
+}
+
+static void put_option(block_t *b, uint16_t code, const void *data, size_t len) {
+    put16(b, code);
+    put16(b, (uint16_t)len);
+    put(b, data, len);
+    pad(b);
+}
+
+// Start a block at the current end of the buffer
+static size_t begin_block(block_t *b, uint32_t type) {
+    size_t start = b->len;
+    put32(b, type);
+    put32(b, 0);    // Total length, patched by end_block()
+    return start;
+}
+
+static void end_block(block_t *b, size_t start) {
+    uint32_t total = (uint32_t)(b->len - start + 4);
+    put32(b, total);
+    if (!b->overflow) {
+        memcpy(b->start + start + 4, &total, sizeof(total));
+    }
+}
+
+static void put_timestamp(block_t *b, const struct timespec *ts) {
+    uint64_t ns = (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+    put32(b, (uint32_t)(ns >> 32));
+    put32(b, (uint32_t)ns);
+}
+
+size_t pcapng_format_header(void *buffer, size_t size, const char *interface_name) {
+    static const char application[] = "cts_monitor";
+    block_t b = { buffer, size, 0, 0 };
+    uint8_t resolution = 9;     // 10^-9 s
+
+    size_t start = begin_block(&b, BLOCK_SECTION_HEADER);
+    put32(&b, 0x1A2B3C4Du);     // Byte-order magic
+    put16(&b, 1);               // Major version
+    put16(&b, 0);               // Minor version
+    put32(&b, 0xFFFFFFFFu);     // Section length unknown (64 bits)
+    put32(&b, 0xFFFFFFFFu);
+    put_option(&b, OPT_SHB_USERAPPL, application, strlen(application));
+    put_option(&b, OPT_END, NULL, 0);
+    end_block(&b, start);
+
+    start = begin_block(&b, BLOCK_INTERFACE);
+    put16(&b, PCAPNG_LINKTYPE);
+    put16(&b, 0);               // Reserved
+    put32(&b, 0);               // No snapshot length limit
+    put_option(&b, OPT_IF_NAME, interface_name, strlen(interface_name));
+    put_option(&b, OPT_IF_TSRESOL, &resolution, sizeof(resolution));
+    put_option(&b, OPT_END, NULL, 0);
+    end_block(&b, start);
+
+    return b.overflow ? 0 : b.len;
+}
+
+size_t pcapng_format_edge(void *buffer, size_t size, uint32_t interface_id,
+                          const struct timespec *ts, signal_id_t signal, int level) {
+    block_t b = { buffer, size, 0, 0 };
+    unsigned char payload[4] = { PCAPNG_PAYLOAD_VERSION, (unsigned char)signal,
+                                 (unsigned char)(level ? 1 : 0), 0 };
+
+    size_t start = begin_block(&b, BLOCK_ENHANCED_PACKET);
+    put32(&b, interface_id);
+    put_timestamp(&b, ts);
+    put32(&b, sizeof(payload));     // Captured length
+    put32(&b, sizeof(payload));     // Original length
+    put(&b, payload, sizeof(payload));
+    end_block(&b, start);
+
+    return b.overflow ? 0 : b.len;
+}
+
+size_t pcapng_format_comment(void *buffer, size_t size, uint32_t interface_id,
+                             const struct timespec *ts, const char *text) {
+    block_t b = { buffer, size, 0, 0 };
+
+    size_t start = begin_block(&b, BLOCK_ENHANCED_PACKET);
+    put32(&b, interface_id);
+    put_timestamp(&b, ts);
+    put32(&b, 0);
+    put32(&b, 0);
+    put_option(&b, OPT_COMMENT, text, strlen(text));
+    put_option(&b, OPT_END, NULL, 0);
+    end_block(&b, start);
+
+    return b.overflow ? 0 : b.len;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "pulse_stats.h"
+#include "timestamp.h"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+static void print_stat(FILE *fp, const char *signal, const char *label, const running_stat_t *stat) {
+    if (stat->count == 0) {
+        return;
+    }
+    fprintf(fp, "%-4s %-7s %10llu %14.3f %14.3f %14.3f %14.3f\n",
+            signal, label, stat->count,
+            stat->min_ns / 1000.0, stat->max_ns / 1000.0,
+            stat->mean_ns / 1000.0, running_stat_stddev(stat) / 1000.0);
+}
+
+void pulse_stats_init(pulse_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void pulse_stats_restart(pulse_stats_t *stats, signal_id_t signal) {
+    stats->signals[signal].have_edge = 0;
+    stats->signals[signal].have_rise = 0;
+}
+
+void running_stat_add(running_stat_t *stat, long long duration_ns) {
+    if (stat->count == 0 || duration_ns < stat->min_ns) {
+        stat->min_ns = duration_ns;
+    }
+    if (stat->count == 0 || duration_ns > stat->max_ns) {
+        stat->max_ns = duration_ns;
+    }
+
+    // Welford's online update keeps the variance numerically stable
+    stat->count++;
+    double delta = (double)duration_ns - stat->mean_ns;
+    stat->mean_ns += delta / (double)stat->count;
+    stat->m2 += delta * ((double)duration_ns - stat->mean_ns);
+}
+
+double running_stat_stddev(const running_stat_t *stat) {
+    if (stat->count < 2) {
+        return 0.0;
+    }
+    return sqrt(stat->m2 / (double)(stat->count - 1));
+}
+
+long long pulse_stats_edge(pulse_stats_t *stats, signal_id_t signal, int new_state,
+                           const struct timespec *ts) {
+    signal_pulse_stats_t *sig = &stats->signals[signal];
+    long long duration = -1;
+
+    if (sig->have_edge) {
+        duration = elapsed_ns(&sig->last_edge, ts);
+        // A falling edge ends a HIGH phase, a rising edge ends a LOW phase
+        running_stat_add(new_state ? &sig->low : &sig->high, duration);
+    }
+    sig->last_edge = *ts;
+    sig->have_edge = 1;
+
+    if (new_state) {
+        if (sig->have_rise) {
+            running_stat_add(&sig->period, elapsed_ns(&sig->last_rise, ts));
+        }
+        sig->last_rise = *ts;
+        sig->have_rise = 1;
+    }
+
+    return duration;
+}
+
+void pulse_stats_print(const pulse_stats_t *stats, FILE *fp) {
+    fprintf(fp, "=== Pulse Statistics (microseconds) ===\n");
+    fprintf(fp, "%-4s %-7s %10s %14s %14s %14s %14s\n",
+            "SIG", "PHASE", "COUNT", "MIN", "MAX", "MEAN", "STDDEV");
+
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        const signal_pulse_stats_t *sig = &stats->signals[i];
+        print_stat(fp, signal_names[i], "high", &sig->high);
+        print_stat(fp, signal_names[i], "low", &sig->low);
+        print_stat(fp, signal_names[i], "period", &sig->period);
+    }
+    fflush(fp);
+}
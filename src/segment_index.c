@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include "segment_index.h"
+
+// Build the index file path for a segmented output
+static int index_path(const char *base_path, char *buffer, size_t size) {
+    int len = snprintf(buffer, size, "%s.idx", base_path);
+    if (len < 0 || (size_t)len >= size) {
+        fprintf(stderr, "Segment index path too long: %s\n", base_path);
+        return -1;
+    }
+    return 0;
+}
+
+void segment_stats_reset(segment_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void segment_stats_record(segment_stats_t *stats, const struct timespec *ts, int is_edge, size_t len) {
+    if (!stats->records) {
+        stats->first = *ts;
+        stats->records = 1;
+    }
+    stats->last = *ts;
+    stats->bytes += len;
+    if (is_edge) {
+        stats->edges++;
+    }
+}
+
+long segment_period_number(const struct timespec *ts, long period_s) {
+    struct tm tm_info;
+    localtime_r(&ts->tv_sec, &tm_info);
+
+    // Shift into local time so periods line up with the wall clock
+    return (long)((ts->tv_sec + tm_info.tm_gmtoff) / period_s);
+}
+
+int segment_index_create(const char *base_path) {
+    char path[PATH_MAX];
+    if (index_path(base_path, path, sizeof(path)) < 0) {
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Error creating segment index %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    fprintf(fp, "# segment first_timestamp last_timestamp edges bytes\n");
+    fclose(fp);
+    return 0;
+}
+
+int segment_index_append(const char *base_path, const char *segment_path,
+                         const segment_stats_t *stats) {
+    char path[PATH_MAX];
+    if (index_path(base_path, path, sizeof(path)) < 0) {
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "a");
+    if (!fp) {
+        fprintf(stderr, "Error opening segment index %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    fprintf(fp, "%s %lld.%06ld %lld.%06ld %lu %llu\n",
+            segment_path,
+            (long long)stats->first.tv_sec, stats->first.tv_nsec / 1000,
+            (long long)stats->last.tv_sec, stats->last.tv_nsec / 1000,
+            stats->edges, stats->bytes);
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Error writing segment index %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm_ring.h"
+
+int shm_ring_writer_open(shm_ring_writer_t *writer, const char *name, size_t slot_count) {
+    size_t slots = 1;
+
+    memset(writer, 0, sizeof(*writer));
+    writer->name = name;
+
+    if (slot_count == 0) {
+        slot_count = SHM_RING_DEFAULT_SLOTS;
+    }
+    while (slots < slot_count) {
+        slots <<= 1;
+    }
+    writer->map_size = sizeof(shm_ring_header_t) + slots * sizeof(shm_ring_slot_t);
+
+    // Readers still mapping a previous ring keep it instead of faulting on the truncation
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error creating shared memory %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)writer->map_size) < 0) {
+        fprintf(stderr, "Error sizing shared memory %s: %s\n", name, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+
+    void *map = mmap(NULL, writer->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping shared memory %s: %s\n", name, strerror(errno));
+        shm_unlink(name);
+        return -1;
+    }
+
+    writer->header = map;
+    writer->slots = (shm_ring_slot_t *)(writer->header + 1);
+    memset(writer->slots, 0xFF, slots * sizeof(shm_ring_slot_t));
+    writer->header->slot_count = (uint32_t)slots;
+    writer->header->slot_size = sizeof(shm_ring_slot_t);
+    writer->header->next_sequence = 0;
+
+    // Magic last, so readers never see a half-initialized header as valid
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(writer->header->magic, SHM_RING_MAGIC, sizeof(writer->header->magic));
+    return 0;
+}
+
+void shm_ring_publish(shm_ring_writer_t *writer, const struct timespec *ts, int signal, int level) {
+    uint64_t sequence = writer->next_sequence;
+    shm_ring_slot_t *slot = &writer->slots[sequence & (writer->header->slot_count - 1)];
+
+    // Mark the slot as being rewritten before touching its contents
+    __atomic_store_n(&slot->sequence, UINT64_MAX, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->time_ns, (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->edge, (uint32_t)(signal & 0xFF) | ((uint32_t)(level ? 1 : 0) << 8),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELEASE);
+
+    writer->next_sequence = sequence + 1;
+    __atomic_store_n(&writer->header->next_sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+void shm_ring_writer_close(shm_ring_writer_t *writer) {
+    if (writer->header) {
+        munmap(writer->header, writer->map_size);
+        writer->header = NULL;
+        shm_unlink(writer->name);
+    }
+}
+
+int shm_ring_reader_open(shm_ring_reader_t *reader, const char *name) {
+    struct stat st;
+
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening shared memory %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shm_ring_header_t)) {
+        fprintf(stderr, "Shared memory %s is not an edge ring\n", name);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping shared memory %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    const shm_ring_header_t *header = map;
+    if (memcmp(header->magic, SHM_RING_MAGIC, sizeof(header->magic)) != 0 ||
+        header->slot_size != sizeof(shm_ring_slot_t) ||
+        sizeof(*header) + (size_t)header->slot_count * sizeof(shm_ring_slot_t) > (size_t)st.st_size) {
+        fprintf(stderr, "Shared memory %s is not an edge ring\n", name);
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    reader->header = header;
+    reader->slots = (const shm_ring_slot_t *)(header + 1);
+    reader->map_size = (size_t)st.st_size;
+    reader->next_sequence = __atomic_load_n(&header->next_sequence, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+int shm_ring_read(shm_ring_reader_t *reader, shm_ring_edge_t *edge, uint64_t *lost) {
+    uint64_t slot_count = reader->header->slot_count;
+
+    *lost = 0;
+    for (;;) {
+        uint64_t head = __atomic_load_n(&reader->header->next_sequence, __ATOMIC_ACQUIRE);
+        if (reader->next_sequence >= head) {
+            return 0;
+        }
+
+        // Lapped by the writer: skip to the oldest edge still in the ring
+        if (head - reader->next_sequence > slot_count) {
+            *lost += head - slot_count - reader->next_sequence;
+            reader->next_sequence = head - slot_count;
+        }
+
+        uint64_t sequence = reader->next_sequence;
+        const shm_ring_slot_t *slot = &reader->slots[sequence & (slot_count - 1)];
+        uint64_t before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        uint64_t time_ns = __atomic_load_n(&slot->time_ns, __ATOMIC_RELAXED);
+        uint32_t packed = __atomic_load_n(&slot->edge, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t after = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+
+        if (before == sequence && after == sequence) {
+            edge->sequence = sequence;
+            edge->time_ns = time_ns;
+            edge->signal = (uint8_t)(packed & 0xFF);
+            edge->level = (uint8_t)((packed >> 8) & 0xFF);
+            reader->next_sequence = sequence + 1;
+            return 1;
+        }
+
+        // Slot overwritten while reading: count it as lost and retry further on
+        (*lost)++;
+        reader->next_sequence = sequence + 1;
+    }
+}
+
+void shm_ring_reader_close(shm_ring_reader_t *reader) {
+    if (reader->header) {
+        munmap((void *)reader->header, reader->map_size);
+        reader->header = NULL;
+    }
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/ioctl.h>
+#include "signal_state.h"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+const signal_id_t signal_state_log_order[SIGNAL_COUNT] = { SIGNAL_RTS, SIGNAL_CTS, SIGNAL_DSR, SIGNAL_DTR };
+
+void signal_state_decode(int status, signal_state_t *state) {
+    state->cts = (status & TIOCM_CTS) ? 1 : 0;
+    state->rts = (status & TIOCM_RTS) ? 1 : 0;
+    state->dsr = (status & TIOCM_DSR) ? 1 : 0;
+    state->dtr = (status & TIOCM_DTR) ? 1 : 0;
+}
+
+int signal_state_encode(int mask) {
+    return ((mask & (1 << SIGNAL_CTS)) ? TIOCM_CTS : 0) |
+           ((mask & (1 << SIGNAL_RTS)) ? TIOCM_RTS : 0) |
+           ((mask & (1 << SIGNAL_DSR)) ? TIOCM_DSR : 0) |
+           ((mask & (1 << SIGNAL_DTR)) ? TIOCM_DTR : 0);
+}
+
+int signal_state_level(const signal_state_t *state, signal_id_t signal) {
+    switch (signal) {
+    case SIGNAL_CTS: return state->cts;
+    case SIGNAL_RTS: return state->rts;
+    case SIGNAL_DSR: return state->dsr;
+    case SIGNAL_DTR: return state->dtr;
+    default: return 0;
+    }
+}
+
+void signal_state_set(signal_state_t *state, signal_id_t signal, int level) {
+    switch (signal) {
+    case SIGNAL_CTS: state->cts = level; break;
+    case SIGNAL_RTS: state->rts = level; break;
+    case SIGNAL_DSR: state->dsr = level; break;
+    case SIGNAL_DTR: state->dtr = level; break;
+    default: break;
+    }
+}
+
+int signal_state_changes(const signal_state_t *previous, const signal_state_t *current, int mask) {
+    // Branch-free: one bit per signal, ordered like signal_id_t
+    int changes = ((previous->cts ^ current->cts) << SIGNAL_CTS) |
+                  ((previous->rts ^ current->rts) << SIGNAL_RTS) |
+                  ((previous->dsr ^ current->dsr) << SIGNAL_DSR) |
+                  ((previous->dtr ^ current->dtr) << SIGNAL_DTR);
+    return changes & mask;
+}
+
+int signal_state_parse_mask(const char *text) {
+    int mask = 0;
+
+    if (strcasecmp(text, "all") == 0) {
+        return (1 << SIGNAL_COUNT) - 1;
+    }
+
+    while (*text) {
+        size_t len = strcspn(text, ",");
+        int signal = SIGNAL_COUNT;
+        for (int i = 0; i < SIGNAL_COUNT; i++) {
+            if (len == strlen(signal_names[i]) && strncasecmp(text, signal_names[i], len) == 0) {
+                signal = i;
+            }
+        }
+        if (signal == SIGNAL_COUNT) {
+            return -1;
+        }
+        mask |= 1 << signal;
+        text += len;
+        if (*text == ',') {
+            text++;
+        }
+    }
+    return mask ? mask : -1;
+}
+
+void signal_state_format_mask(int mask, char *buffer, size_t size) {
+    size_t len = 0;
+
+    buffer[0] = '\0';
+    for (int i = 0; i < SIGNAL_COUNT && len < size; i++) {
+        if (mask & (1 << i)) {
+            len += (size_t)snprintf(buffer + len, size - len, "%s%s", len ? "," : "", signal_names[i]);
+        }
+    }
+}
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "stream_server.h"
+#include "unix_socket.h"
+
+static void drop_client(stream_client_t *client) {
+    close(client->fd);
+    free(client->queue);
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+}
+
+int stream_server_open(stream_server_t *server, const char *path, size_t queue_size) {
+    memset(server, 0, sizeof(*server));
+    server->path = path;
+    server->queue_size = queue_size ? queue_size : STREAM_SERVER_DEFAULT_QUEUE;
+    for (int i = 0; i < STREAM_SERVER_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+    }
+
+    server->listen_fd = unix_socket_listen(path, STREAM_SERVER_MAX_CLIENTS, "stream");
+    return server->listen_fd < 0 ? -1 : 0;
+}
+
+// Send as much of the queue as the socket takes without blocking
+static void flush_client(stream_server_t *server, stream_client_t *client) {
+    while (client->count > 0) {
+        size_t chunk = server->queue_size - client->head;
+        if (chunk > client->count) {
+            chunk = client->count;
+        }
+        ssize_t sent = send(client->fd, client->queue + client->head, chunk,
+                            MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                drop_client(client);
+            }
+            return;
+        }
+        client->head = (client->head + (size_t)sent) % server->queue_size;
+        client->count -= (size_t)sent;
+    }
+}
+
+static void enqueue(stream_server_t *server, stream_client_t *client, const void *data, size_t len) {
+    if (client->count + len > server->queue_size) {
+        // Subscriber fell behind: disconnect instead of stalling the capture
+        drop_client(client);
+        server->disconnected++;
+        return;
+    }
+
+    size_t tail = (client->head + client->count) % server->queue_size;
+    size_t first = server->queue_size - tail;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(client->queue + tail, data, first);
+    memcpy(client->queue, (const char *)data + first, len - first);
+    client->count += len;
+}
+
+static void accept_clients(stream_server_t *server) {
+    int fd;
+
+    while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        stream_client_t *client = NULL;
+        for (int i = 0; i < STREAM_SERVER_MAX_CLIENTS && !client; i++) {
+            if (server->clients[i].state == STREAM_CLIENT_FREE) {
+                client = &server->clients[i];
+            }
+        }
+
+        char *queue = client ? malloc(server->queue_size) : NULL;
+        if (!queue) {
+            close(fd);  // Full or out of memory
+            continue;
+        }
+        client->fd = fd;
+        client->state = STREAM_CLIENT_PENDING;
+        client->queue = queue;
+    }
+}
+
+// Read the subscription line of a pending client
+static void read_request(stream_client_t *client) {
+    ssize_t n = recv(client->fd, client->request + client->request_len,
+                     sizeof(client->request) - 1 - client->request_len, MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        drop_client(client);
+        return;
+    }
+    if (n < 0) {
+        return;
+    }
+
+    client->request_len += (size_t)n;
+    client->request[client->request_len] = '\0';
+    char *newline = strchr(client->request, '\n');
+    if (!newline) {
+        if (client->request_len == sizeof(client->request) - 1) {
+            drop_client(client);
+        }
+        return;
+    }
+
+    *newline = '\0';
+    if (newline > client->request && newline[-1] == '\r') {
+        newline[-1] = '\0';
+    }
+    if (strcmp(client->request, "text") == 0) {
+        client->state = STREAM_CLIENT_TEXT;
+    } else if (strcmp(client->request, "binary") == 0) {
+        client->state = STREAM_CLIENT_BINARY;
+    } else {
+        drop_client(client);
+    }
+}
+
+void stream_server_service(stream_server_t *server) {
+    struct pollfd fds[STREAM_SERVER_MAX_CLIENTS + 1];
+    int slots[STREAM_SERVER_MAX_CLIENTS + 1];
+    nfds_t nfds = 0;
+
+    fds[nfds].fd = server->listen_fd;
+    fds[nfds].events = POLLIN;
+    slots[nfds++] = -1;
+    for (int i = 0; i < STREAM_SERVER_MAX_CLIENTS; i++) {
+        stream_client_t *client = &server->clients[i];
+        if (client->state == STREAM_CLIENT_FREE) {
+            continue;
+        }
+        fds[nfds].fd = client->fd;
+        fds[nfds].events = POLLIN | (client->count ? POLLOUT : 0);
+        slots[nfds++] = i;
+    }
+
+    if (poll(fds, nfds, 0) <= 0) {
+        return;
+    }
+
+    for (nfds_t i = 0; i < nfds; i++) {
+        if (!fds[i].revents) {
+            continue;
+        }
+        if (slots[i] < 0) {
+            accept_clients(server);
+            continue;
+        }
+
+        stream_client_t *client = &server->clients[slots[i]];
+        if (client->state == STREAM_CLIENT_PENDING) {
+            read_request(client);
+        } else if (fds[i].revents & (POLLHUP | POLLERR)) {
+            drop_client(client);
+        } else if (fds[i].revents & POLLIN) {
+            // Subscribed clients have nothing more to say; detect hang-ups
+            char discard[64];
+            ssize_t n = recv(client->fd, discard, sizeof(discard), MSG_DONTWAIT);
+            if (n == 0) {
+                drop_client(client);
+            }
+        }
+        if (client->state != STREAM_CLIENT_FREE && (fds[i].revents & POLLOUT)) {
+            flush_client(server, client);
+        }
+    }
+}
+
+void stream_server_publish(stream_server_t *server, const struct timespec *ts,
+                           signal_id_t signal, int level, const char *text, size_t text_len) {
+    stream_edge_t edge;
+
+    memset(&edge, 0, sizeof(edge));
+    edge.time_ns = (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+    edge.sequence = server->sequence++;
+    edge.signal = (uint8_t)signal;
+    edge.level = (uint8_t)(level ? 1 : 0);
+
+    for (int i = 0; i < STREAM_SERVER_MAX_CLIENTS; i++) {
+        stream_client_t *client = &server->clients[i];
+        if (client->state == STREAM_CLIENT_TEXT) {
+            enqueue(server, client, text, text_len);
+        } else if (client->state == STREAM_CLIENT_BINARY) {
+            enqueue(server, client, &edge, sizeof(edge));
+        } else {
+            continue;
+        }
+        if (client->state != STREAM_CLIENT_FREE) {
+            flush_client(server, client);
+        }
+    }
+}
+
+void stream_server_close(stream_server_t *server) {
+    for (int i = 0; i < STREAM_SERVER_MAX_CLIENTS; i++) {
+        if (server->clients[i].state != STREAM_CLIENT_FREE) {
+            drop_client(&server->clients[i]);
+        }
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        unlink(server->path);
+    }
+}
@@ -0,0 +1,24 @@
+#include <stdio.h>
+#include <time.h>
+#include "timestamp.h"
+
+void timestamp_format(const struct timespec *ts, const struct timespec *start,
+                      time_format_t format, char *buffer, size_t size) {
+    if (format == TIME_FORMAT_ABSOLUTE) {
+        // Absolute time with microsecond precision
+        struct tm tm_info;
+        localtime_r(&ts->tv_sec, &tm_info);
+        size_t len = strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &tm_info);
+        snprintf(buffer + len, size - len, ".%06ld", ts->tv_nsec / 1000);
+    } else {
+        // Relative time from start in microseconds; times before the start
+        // get a sign instead of a negative fraction
+        long long total_us = (long long)(ts->tv_sec - start->tv_sec) * 1000000LL +
+                             (ts->tv_nsec - start->tv_nsec) / 1000;
+        const char *sign = total_us < 0 ? "-" : "";
+        if (total_us < 0) {
+            total_us = -total_us;
+        }
+        snprintf(buffer, size, "%s%lld.%06lld", sign, total_us / 1000000, total_us % 1000000);
+    }
+}
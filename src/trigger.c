@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "trigger.h"
+#include "timestamp.h"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+int trigger_parse_duration(const char *text, long long *ns) {
+    char *end;
+    long long value = strtoll(text, &end, 10);
+
+    if (end == text || value < 0) {
+        return -1;
+    }
+    if (*end == '\0' || strcasecmp(end, "us") == 0) {
+        *ns = value * 1000LL;
+    } else if (strcasecmp(end, "ms") == 0) {
+        *ns = value * 1000000LL;
+    } else if (strcasecmp(end, "s") == 0) {
+        *ns = value * 1000000000LL;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Parse "SIG=LEVEL" at the start of term, returning the rest of the term
+static const char *parse_level_term(const char *term, signal_id_t *signal, int *level) {
+    const char *eq = strchr(term, '=');
+    if (!eq) {
+        return NULL;
+    }
+
+    *signal = SIGNAL_COUNT;
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if ((size_t)(eq - term) == strlen(signal_names[i]) &&
+            strncasecmp(term, signal_names[i], eq - term) == 0) {
+            *signal = (signal_id_t)i;
+        }
+    }
+    if (*signal == SIGNAL_COUNT) {
+        return NULL;
+    }
+
+    const char *value = eq + 1;
+    size_t len = strcspn(value, "<>");
+    if (len == 4 && strncasecmp(value, "HIGH", 4) == 0) {
+        *level = 1;
+    } else if (len == 3 && strncasecmp(value, "LOW", 3) == 0) {
+        *level = 0;
+    } else if (len == 1 && (value[0] == '0' || value[0] == '1')) {
+        *level = value[0] - '0';
+    } else {
+        return NULL;
+    }
+    return value + len;
+}
+
+// Parse one condition; term is modified in place
+static int parse_condition(char *term, trigger_condition_t *cond) {
+    char *qualifiers = strchr(term, '&');
+    if (qualifiers) {
+        *qualifiers++ = '\0';
+    }
+
+    memset(cond, 0, sizeof(*cond));
+    const char *rest = parse_level_term(term, &cond->signal, &cond->level);
+    if (!rest) {
+        return -1;
+    }
+    if (*rest == '\0') {
+        cond->kind = TRIGGER_EDGE;
+    } else {
+        cond->kind = (*rest == '>') ? TRIGGER_HELD : TRIGGER_SHORT;
+        if (trigger_parse_duration(rest + 1, &cond->width_ns) < 0) {
+            return -1;
+        }
+    }
+
+    while (qualifiers) {
+        char *next = strchr(qualifiers, '&');
+        if (next) {
+            *next++ = '\0';
+        }
+        signal_id_t signal;
+        int level;
+        rest = parse_level_term(qualifiers, &signal, &level);
+        if (!rest || *rest != '\0') {
+            return -1;
+        }
+        cond->qualifier_mask |= 1 << signal;
+        if (level) {
+            cond->qualifier_levels |= 1 << signal;
+        }
+        qualifiers = next;
+    }
+    return 0;
+}
+
+static int parse_expression(trigger_t *trig, const char *expression) {
+    char copy[256];
+    if (snprintf(copy, sizeof(copy), "%s", expression) >= (int)sizeof(copy)) {
+        return -1;
+    }
+
+    trig->condition_count = 0;
+    for (char *term = copy; term; ) {
+        char *next = strchr(term, ',');
+        if (next) {
+            *next++ = '\0';
+        }
+        if (trig->condition_count == TRIGGER_MAX_CONDITIONS ||
+            parse_condition(term, &trig->conditions[trig->condition_count]) < 0) {
+            return -1;
+        }
+        trig->condition_count++;
+        term = next;
+    }
+    return 0;
+}
+
+int trigger_init(trigger_t *trig, const char *expression, size_t capacity,
+                 long long post_ns, const signal_state_t *initial, const struct timespec *now) {
+    memset(trig, 0, sizeof(*trig));
+
+    if (parse_expression(trig, expression) < 0) {
+        fprintf(stderr, "Invalid trigger expression: %s\n", expression);
+        return -1;
+    }
+
+    trig->events = malloc(capacity * sizeof(*trig->events));
+    if (!trig->events) {
+        fprintf(stderr, "Out of memory allocating %zu-edge trigger buffer\n", capacity);
+        return -1;
+    }
+    trig->capacity = capacity;
+    trig->post_ns = post_ns;
+
+    trig->levels[SIGNAL_CTS] = initial->cts;
+    trig->levels[SIGNAL_RTS] = initial->rts;
+    trig->levels[SIGNAL_DSR] = initial->dsr;
+    trig->levels[SIGNAL_DTR] = initial->dtr;
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        trig->since[i] = *now;
+    }
+    return 0;
+}
+
+void trigger_free(trigger_t *trig) {
+    free(trig->events);
+    trig->events = NULL;
+    trig->capacity = 0;
+}
+
+int trigger_capturing(trigger_t *trig, const struct timespec *now) {
+    if (trig->capturing && elapsed_ns(&trig->fire_time, now) > trig->post_ns) {
+        trig->capturing = 0;
+        trig->head = 0;
+        trig->count = 0;
+    }
+    return trig->capturing;
+}
+
+static int qualified(const trigger_t *trig, const trigger_condition_t *cond) {
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if ((cond->qualifier_mask & (1 << i)) &&
+            trig->levels[i] != ((cond->qualifier_levels >> i) & 1)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void fire(trigger_t *trig, const struct timespec *ts) {
+    trig->capturing = 1;
+    trig->fire_time = *ts;
+    trig->fired++;
+}
+
+void trigger_track(trigger_t *trig, signal_id_t signal, int new_state, const struct timespec *ts) {
+    trig->levels[signal] = new_state;
+    trig->since[signal] = *ts;
+    trig->held_fired[signal] = 0;
+}
+
+int trigger_edge(trigger_t *trig, signal_id_t signal, int new_state, const struct timespec *ts) {
+    long long duration = elapsed_ns(&trig->since[signal], ts);
+    int held_fired = trig->held_fired[signal];
+    int fired = 0;
+
+    // Overwrite the oldest edge once the buffer is full
+    trigger_event_t *event = &trig->events[(trig->head + trig->count) % trig->capacity];
+    if (trig->count == trig->capacity) {
+        trig->head = (trig->head + 1) % trig->capacity;
+    } else {
+        trig->count++;
+    }
+    event->ts = *ts;
+    event->signal = (unsigned char)signal;
+    event->state = (unsigned char)new_state;
+
+    trigger_track(trig, signal, new_state, ts);
+
+    for (int i = 0; i < trig->condition_count && !fired; i++) {
+        const trigger_condition_t *cond = &trig->conditions[i];
+        if (cond->signal != signal || !qualified(trig, cond)) {
+            continue;
+        }
+        switch (cond->kind) {
+        case TRIGGER_EDGE:
+            fired = cond->level == new_state;
+            break;
+        case TRIGGER_SHORT:
+            fired = cond->level != new_state && duration < cond->width_ns;
+            break;
+        case TRIGGER_HELD:
+            // Held phase that ended before trigger_check() saw it
+            fired = cond->level != new_state && duration > cond->width_ns && !held_fired;
+            break;
+        }
+    }
+
+    if (fired) {
+        fire(trig, ts);
+    }
+    return fired;
+}
+
+int trigger_check(trigger_t *trig, const struct timespec *now) {
+    if (trig->capturing) {
+        return 0;
+    }
+
+    for (int i = 0; i < trig->condition_count; i++) {
+        const trigger_condition_t *cond = &trig->conditions[i];
+        signal_id_t signal = cond->signal;
+        if (cond->kind != TRIGGER_HELD || trig->held_fired[signal] ||
+            trig->levels[signal] != cond->level || !qualified(trig, cond) ||
+            elapsed_ns(&trig->since[signal], now) <= cond->width_ns) {
+            continue;
+        }
+
+        // Fire at the moment the hold exceeded the width
+        struct timespec at = add_ns(&trig->since[signal], cond->width_ns);
+
+        trig->held_fired[signal] = 1;
+        fire(trig, &at);
+        return 1;
+    }
+    return 0;
+}
+
+int trigger_pop(trigger_t *trig, trigger_event_t *event) {
+    if (trig->count == 0) {
+        return 0;
+    }
+    *event = trig->events[trig->head];
+    trig->head = (trig->head + 1) % trig->capacity;
+    trig->count--;
+    return 1;
+}
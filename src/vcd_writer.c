@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "vcd_writer.h"
+
+static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+
+void vcd_writer_init(vcd_writer_t *vcd, const struct timespec *start) {
+    vcd->start = *start;
+    vcd->last_time_ns = -1;
+}
+
+char vcd_identifier(signal_id_t signal) {
+    return (char)('!' + signal);
+}
+
+static int signal_level(const signal_state_t *state, int signal) {
+    switch (signal) {
+    case SIGNAL_CTS: return state->cts;
+    case SIGNAL_RTS: return state->rts;
+    case SIGNAL_DSR: return state->dsr;
+    default:         return state->dtr;
+    }
+}
+
+int vcd_format_header(vcd_writer_t *vcd, char *buffer, size_t size, int line,
+                      int signal_mask, const signal_state_t *initial) {
+    char date[32];
+    struct tm tm_info;
+
+    // Fixed preamble
+    switch (line) {
+    case 0:
+        localtime_r(&vcd->start.tv_sec, &tm_info);
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm_info);
+        return snprintf(buffer, size, "$date %s.%06ld $end\n", date, vcd->start.tv_nsec / 1000);
+    case 1:
+        return snprintf(buffer, size, "$version cts_monitor $end\n");
+    case 2:
+        return snprintf(buffer, size, "$timescale 1ns $end\n");
+    case 3:
+        return snprintf(buffer, size, "$scope module serial $end\n");
+    }
+    line -= 4;
+
+    // One wire per signal
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if ((signal_mask & (1 << i)) && line-- == 0) {
+            return snprintf(buffer, size, "$var wire 1 %c %s $end\n",
+                            vcd_identifier((signal_id_t)i), signal_names[i]);
+        }
+    }
+
+    switch (line) {
+    case 0:
+        return snprintf(buffer, size, "$upscope $end\n");
+    case 1:
+        return snprintf(buffer, size, "$enddefinitions $end\n");
+    case 2:
+        vcd->last_time_ns = 0;
+        return snprintf(buffer, size, "#0\n$dumpvars\n");
+    }
+    line -= 3;
+
+    // Initial levels
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if ((signal_mask & (1 << i)) && line-- == 0) {
+            return snprintf(buffer, size, "%d%c\n", signal_level(initial, i),
+                            vcd_identifier((signal_id_t)i));
+        }
+    }
+
+    if (line == 0) {
+        return snprintf(buffer, size, "$end\n");
+    }
+    return 0;
+}
+
+int vcd_format_change(vcd_writer_t *vcd, char *buffer, size_t size,
+                      const struct timespec *ts, signal_id_t signal, int level) {
+    long long time_ns = (long long)(ts->tv_sec - vcd->start.tv_sec) * 1000000000LL +
+                        (ts->tv_nsec - vcd->start.tv_nsec);
+
+    if (time_ns <= vcd->last_time_ns) {
+        return snprintf(buffer, size, "%d%c\n", level, vcd_identifier(signal));
+    }
+
+    vcd->last_time_ns = time_ns;
+    return snprintf(buffer, size, "#%lld\n%d%c\n", time_ns, level, vcd_identifier(signal));
+}
@@ -0,0 +1,81 @@
+// Handshake analysis of RTS and CTS edges seen in the same sample
+//
+// With a 300 us virtual sample clock and CTS following RTS by 50 us, every
+// RTS edge shares its sample with the CTS response. Each pair must be
+// recorded with a latency of 0 and none may time out.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cts_monitor.h"
+
+#define TEST_DEVICE "synthetic:step=300us,RTS=100,CTS=RTS+50us"
+
+// 0.3 s of virtual time: 60 RTS edges
+#define TEST_SAMPLES 1000
+
+int main(void) {
+    monitor_config_t config;
+    char line[256];
+    int failed = 0;
+    int directions = 0;
+
+    memset(&config, 0, sizeof(config));
+    config.serial_device = TEST_DEVICE;
+    config.poll_interval_us = 1000;
+    config.mode = MONITOR_MODE_POLLING;
+    config.output_backend = OUTPUT_BACKEND_NONE;
+    config.handshake = 1;
+    config.handshake_timeout_us = 1000;
+    config.replay_speed = 1.0;
+
+    cts_monitor_t *monitor = cts_monitor_create(&config);
+    if (!monitor) {
+        fprintf(stderr, "FAIL: monitor initialization failed\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        if (cts_monitor_update(monitor) != 0) {
+            fprintf(stderr, "FAIL: update failed\n");
+            cts_monitor_destroy(monitor);
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *fp = tmpfile();
+    if (!fp) {
+        perror("tmpfile");
+        cts_monitor_destroy(monitor);
+        return EXIT_FAILURE;
+    }
+    cts_monitor_print_stats(monitor, fp);
+    cts_monitor_destroy(monitor);
+
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long long pairs, timeouts, unanswered;
+        double p50;
+        const char *fields = strstr(line, "pairs=");
+
+        if (!fields || sscanf(fields, "pairs=%llu timeouts=%llu unanswered=%llu p50=%lf",
+                              &pairs, &timeouts, &unanswered, &p50) != 4) {
+            continue;
+        }
+        directions++;
+        if (pairs < 25 || timeouts != 0 || unanswered != 0 || p50 != 0.0) {
+            fprintf(stderr, "FAIL: %s", line);
+            failed = 1;
+        }
+    }
+    fclose(fp);
+
+    if (directions != 2) {
+        fprintf(stderr, "FAIL: expected a summary line per direction, got %d\n", directions);
+        failed = 1;
+    }
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+    printf("PASS: test_handshake\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "hdr_histogram.h"
+
+typedef struct {
+    char name[HDR_NAME_MAX];
+    hdr_histogram_t hist;
+} named_histogram_t;
+
+static named_histogram_t *histograms = NULL;
+static size_t histogram_count = 0;
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options] <histogram file>...\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help     Show this help message\n");
+    printf("  -o FILE        Write the merged histograms to FILE\n");
+    printf("\n");
+    printf("Merges histogram blobs written by cts_monitor --hist (histograms with\n");
+    printf("the same name are combined) and prints a percentile table.\n");
+}
+
+// Find the histogram with a given name, adding an empty one if needed
+static hdr_histogram_t *lookup(const char *name) {
+    for (size_t i = 0; i < histogram_count; i++) {
+        if (strcmp(histograms[i].name, name) == 0) {
+            return &histograms[i].hist;
+        }
+    }
+
+    named_histogram_t *grown = realloc(histograms, (histogram_count + 1) * sizeof(*grown));
+    if (!grown) {
+        fprintf(stderr, "Out of memory\n");
+        return NULL;
+    }
+    histograms = grown;
+
+    named_histogram_t *entry = &histograms[histogram_count++];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    hdr_histogram_reset(&entry->hist);
+    return &entry->hist;
+}
+
+static int merge_file(const char *path) {
+    static hdr_histogram_t hist;
+    char name[HDR_NAME_MAX];
+    int result;
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while ((result = hdr_histogram_read(fp, name, &hist)) == 1) {
+        hdr_histogram_t *dst = lookup(name);
+        if (!dst) {
+            fclose(fp);
+            return -1;
+        }
+        hdr_histogram_merge(dst, &hist);
+    }
+
+    fclose(fp);
+    if (result < 0) {
+        fprintf(stderr, "Error: %s is not a valid histogram file\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *output_file = NULL;
+    int file_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        else if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 < argc) {
+                output_file = argv[++i];
+            } else {
+                fprintf(stderr, "Error: -o option requires an output file\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i][0] != '-') {
+            if (merge_file(argv[i]) < 0) {
+                return EXIT_FAILURE;
+            }
+            file_count++;
+        }
+        else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (file_count == 0) {
+        fprintf(stderr, "Error: At least one histogram file must be specified\n");
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("=== Merged Histograms (microseconds, %d files) ===\n", file_count);
+    hdr_histogram_print_header(stdout);
+    for (size_t i = 0; i < histogram_count; i++) {
+        hdr_histogram_print(&histograms[i].hist, histograms[i].name, stdout);
+    }
+
+    if (output_file) {
+        int failed = 0;
+        FILE *fp = fopen(output_file, "wb");
+        if (!fp) {
+            fprintf(stderr, "Error opening %s: %s\n", output_file, strerror(errno));
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < histogram_count; i++) {
+            failed |= hdr_histogram_write(fp, histograms[i].name, &histograms[i].hist);
+        }
+        if (fclose(fp) != 0 || failed) {
+            fprintf(stderr, "Error writing %s\n", output_file);
+            return EXIT_FAILURE;
+        }
+    }
+
+    free(histograms);
+    return EXIT_SUCCESS;
+}
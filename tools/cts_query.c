@@ -0,0 +1,616 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "log_parse.h"
+
+// Distance between sparse index entries in bytes
+#define INDEX_STRIDE (64 * 1024)
+
+// Cached index file format
+#define INDEX_MAGIC "CTSQIDX1"
+#define INDEX_VERSION 1
+
+// Longest log line considered when probing for an index entry
+#define PROBE_SIZE 4096
+
+typedef struct {
+    int64_t time_us;        // Timestamp of the first line at or after the stride point
+    uint64_t offset;        // File offset of that line
+} index_entry_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t stride;
+    uint64_t device;        // st_dev of the indexed log
+    uint64_t inode;         // st_ino of the indexed log
+    uint64_t file_size;     // Log size when the index was written
+    uint64_t count;         // Number of entries following the header
+} index_header_t;
+
+typedef struct {
+    index_entry_t *entries;
+    size_t count;
+    size_t capacity;
+} sparse_index_t;
+
+typedef struct {
+    long long from_us;
+    long long to_us;
+    unsigned int signal_mask;   // Bit per signal_id_t
+    int all_records;            // Include non-edge records
+    int count_only;
+    int rebuild;
+    int with_filename;
+} query_t;
+
+static char output_buffer[1 << 20];
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options] --from TIME --to TIME <log|index.idx>...\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help     Show this help message\n");
+    printf("  --from TIME    Start of the time range (inclusive)\n");
+    printf("  --to TIME      End of the time range (inclusive)\n");
+    printf("  -s SIGNALS     Comma-separated signals to report (default: all)\n");
+    printf("  -a, --all      Include non-edge records (banners, status lines)\n");
+    printf("  -c, --count    Print the number of matching records per file\n");
+    printf("  --rebuild      Rebuild cached indexes\n");
+    printf("\n");
+    printf("Time Formats:\n");
+    printf("  YYYY-MM-DD HH:MM:SS[.uuuuuu]  Absolute local time\n");
+    printf("  HH:MM[:SS]                    Time of day on the date of the first record\n");
+    printf("  SECONDS[.uuuuuu]              Relative time (logs written with -f rel)\n");
+    printf("\n");
+    printf("Arguments ending in .idx are segment indexes written by log rotation;\n");
+    printf("only segments overlapping the time range are searched.\n");
+    printf("Sparse indexes are cached next to each log as <log>.qidx.\n");
+}
+
+static int index_append(sparse_index_t *index, int64_t time_us, uint64_t offset) {
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 1024;
+        index_entry_t *entries = realloc(index->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            fprintf(stderr, "Out of memory building index\n");
+            return -1;
+        }
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+    index->entries[index->count].time_us = time_us;
+    index->entries[index->count].offset = offset;
+    index->count++;
+    return 0;
+}
+
+// Load a cached index if it still describes the log (possibly grown since)
+static int load_index(const char *index_path, const struct stat *st, sparse_index_t *index) {
+    index_header_t header;
+    FILE *fp = fopen(index_path, "rb");
+    if (!fp) {
+        return -1;
+    }
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != INDEX_VERSION || header.stride != INDEX_STRIDE ||
+        header.device != (uint64_t)st->st_dev || header.inode != (uint64_t)st->st_ino ||
+        header.file_size > (uint64_t)st->st_size) {
+        fclose(fp);
+        return -1;
+    }
+
+    index->entries = malloc(header.count ? header.count * sizeof(index_entry_t) : 1);
+    if (!index->entries ||
+        fread(index->entries, sizeof(index_entry_t), header.count, fp) != header.count) {
+        free(index->entries);
+        index->entries = NULL;
+        fclose(fp);
+        return -1;
+    }
+    index->count = header.count;
+    index->capacity = header.count;
+
+    fclose(fp);
+    return 0;
+}
+
+static void save_index(const char *index_path, const struct stat *st, const sparse_index_t *index) {
+    index_header_t header;
+    char tmp_path[PATH_MAX + 32];
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.stride = INDEX_STRIDE;
+    header.device = (uint64_t)st->st_dev;
+    header.inode = (uint64_t)st->st_ino;
+    header.file_size = (uint64_t)st->st_size;
+    header.count = index->count;
+
+    // Write to a temporary file so concurrent queries never see a partial index
+    int len = snprintf(tmp_path, sizeof(tmp_path), "%s.%ld", index_path, (long)getpid());
+    if (len < 0 || (size_t)len >= sizeof(tmp_path)) {
+        return;
+    }
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        return;  // Caching is best effort, e.g. read-only log directories
+    }
+
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(index->entries, sizeof(index_entry_t), index->count, fp) != index->count ||
+        fclose(fp) != 0) {
+        unlink(tmp_path);
+        return;
+    }
+
+    if (rename(tmp_path, index_path) < 0) {
+        unlink(tmp_path);
+    }
+}
+
+// Check that an entry still matches the log, catching logs rewritten in place
+static int entry_valid(int fd, const index_entry_t *entry) {
+    char probe[PROBE_SIZE];
+    log_parser_t parser;
+    log_record_t record;
+
+    ssize_t n = pread(fd, probe, sizeof(probe), (off_t)entry->offset);
+    if (n <= 0) {
+        return 0;
+    }
+    char *newline = memchr(probe, '\n', (size_t)n);
+    if (!newline) {
+        return 0;
+    }
+
+    log_parser_init(&parser);
+    return log_parse_line(&parser, probe, (size_t)(newline - probe), &record) == 0 &&
+           record.time_us == entry->time_us;
+}
+
+// Probe stride points with pread() so only one page per stride is read
+static int extend_index(int fd, off_t file_size, sparse_index_t *index) {
+    char probe[PROBE_SIZE];
+    log_parser_t parser;
+    off_t offset = 0;
+
+    log_parser_init(&parser);
+
+    if (index->count > 0) {
+        offset = (off_t)index->entries[index->count - 1].offset + INDEX_STRIDE;
+    }
+
+    while (offset < file_size) {
+        ssize_t n = pread(fd, probe, sizeof(probe), offset);
+        if (n <= 0) {
+            break;
+        }
+
+        // Skip to the start of the next complete line
+        size_t pos = 0;
+        if (offset > 0) {
+            char *newline = memchr(probe, '\n', (size_t)n);
+            if (!newline) {
+                break;
+            }
+            pos = (size_t)(newline - probe) + 1;
+        }
+
+        // Use the first timestamped line at or after the stride point
+        int found = 0;
+        while (pos < (size_t)n) {
+            char *newline = memchr(probe + pos, '\n', (size_t)n - pos);
+            if (!newline) {
+                break;
+            }
+            size_t len = (size_t)(newline - probe) - pos;
+            log_record_t record;
+            if (log_parse_line(&parser, probe + pos, len, &record) == 0) {
+                if (index_append(index, record.time_us, (uint64_t)offset + pos) < 0) {
+                    return -1;
+                }
+                found = 1;
+                break;
+            }
+            pos += len + 1;
+        }
+        if (!found) {
+            if (pos < (size_t)n) {
+                break;  // Incomplete line at the end of a growing log
+            }
+            offset += (off_t)pos;
+            continue;
+        }
+
+        offset = (off_t)index->entries[index->count - 1].offset + INDEX_STRIDE;
+    }
+
+    return 0;
+}
+
+// Read the date of the first record, used for time-of-day arguments
+static int first_record_time(const char *path, long long *time_us, int *relative) {
+    char line[PROBE_SIZE];
+    log_parser_t parser;
+    log_record_t record;
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return -1;
+    }
+    log_parser_init(&parser);
+    while (fgets(line, sizeof(line), fp)) {
+        if (log_parse_line(&parser, line, strcspn(line, "\n"), &record) == 0) {
+            fclose(fp);
+            *time_us = record.time_us;
+            *relative = record.relative;
+            return 0;
+        }
+    }
+    fclose(fp);
+    return -1;
+}
+
+// Stream matching records from one log file
+static long long query_file(const char *path, const query_t *query) {
+    char index_path[4096];
+    sparse_index_t index = { NULL, 0, 0 };
+    struct stat st;
+    long long matches = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "Error reading %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    snprintf(index_path, sizeof(index_path), "%s.qidx", path);
+    size_t cached = 0;
+    if (!query->rebuild && load_index(index_path, &st, &index) == 0) {
+        if (index.count == 0 || entry_valid(fd, &index.entries[index.count - 1])) {
+            cached = index.count;
+        } else {
+            index.count = 0;
+        }
+    }
+    if (extend_index(fd, st.st_size, &index) < 0) {
+        free(index.entries);
+        close(fd);
+        return -1;
+    }
+    if (index.count != cached || query->rebuild) {
+        save_index(index_path, &st, &index);
+    }
+
+    // Binary search: last entry before the range and first entry after it
+    size_t lo = 0, hi = index.count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index.entries[mid].time_us < query->from_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    off_t start = lo > 0 ? (off_t)index.entries[lo - 1].offset : 0;
+
+    hi = index.count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index.entries[mid].time_us <= query->to_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    off_t end = lo < index.count ? (off_t)index.entries[lo].offset : st.st_size;
+    free(index.entries);
+
+    if (start >= end) {
+        close(fd);
+        return 0;
+    }
+
+    // Map only the region that can contain matching records
+    long page_size = sysconf(_SC_PAGESIZE);
+    off_t map_start = start & ~((off_t)page_size - 1);
+    size_t map_len = (size_t)(end - map_start);
+    char *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, map_start);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    madvise(map, map_len, MADV_SEQUENTIAL);
+
+    log_parser_t parser;
+    log_parser_init(&parser);
+
+    const char *p = map + (start - map_start);
+    const char *limit = map + map_len;
+    while (p < limit) {
+        const char *newline = memchr(p, '\n', (size_t)(limit - p));
+        size_t len = newline ? (size_t)(newline - p) : (size_t)(limit - p);
+        log_record_t record;
+
+        if (log_parse_line(&parser, p, len, &record) == 0) {
+            if (record.time_us > query->to_us) {
+                break;
+            }
+            if (record.time_us >= query->from_us &&
+                (record.is_edge ? (query->signal_mask & (1u << record.signal)) != 0
+                                : query->all_records)) {
+                matches++;
+                if (!query->count_only) {
+                    if (query->with_filename) {
+                        fputs(path, stdout);
+                        fputc(':', stdout);
+                    }
+                    fwrite(p, 1, len, stdout);
+                    fputc('\n', stdout);
+                }
+            }
+        }
+
+        if (!newline) {
+            break;
+        }
+        p = newline + 1;
+    }
+
+    munmap(map, map_len);
+    return matches;
+}
+
+// Query the segments of a rotated log that overlap the time range
+static long long query_segment_index(const char *idx_path, const query_t *query) {
+    char line[8192];
+    char dir_buffer[4096];
+    long long total = 0;
+    long long origin_us = 0;    // Epoch time of relative time 0
+    int origin_known = 0;
+
+    FILE *fp = fopen(idx_path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error opening segment index %s: %s\n", idx_path, strerror(errno));
+        return -1;
+    }
+
+    snprintf(dir_buffer, sizeof(dir_buffer), "%s", idx_path);
+    const char *dir = dirname(dir_buffer);
+
+    while (fgets(line, sizeof(line), fp)) {
+        char segment[4096];
+        long long first_s, first_us, last_s, last_us;
+
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%4095s %lld.%lld %lld.%lld", segment,
+                   &first_s, &first_us, &last_s, &last_us) != 5) {
+            continue;
+        }
+
+        // Segment paths are recorded as given at capture time
+        char path[8192];
+        if (segment[0] == '/' || access(segment, R_OK) == 0) {
+            snprintf(path, sizeof(path), "%s", segment);
+        } else {
+            char base_buffer[4096];
+            snprintf(base_buffer, sizeof(base_buffer), "%s", segment);
+            snprintf(path, sizeof(path), "%s/%s", dir, basename(base_buffer));
+        }
+
+        // The index is in epoch time; logs written with -f rel count from the capture
+        // start, which follows from the first record of the first readable segment
+        if (!origin_known) {
+            long long record_us;
+            int relative;
+            if (first_record_time(path, &record_us, &relative) == 0) {
+                origin_us = relative ? first_s * 1000000LL + first_us - record_us : 0;
+                origin_known = 1;
+            }
+        }
+
+        // One microsecond of slack covers the rounding of relative timestamps
+        long long slack = origin_us != 0;
+        if (origin_known &&
+            (last_s * 1000000LL + last_us - origin_us + slack < query->from_us ||
+             first_s * 1000000LL + first_us - origin_us - slack > query->to_us)) {
+            continue;
+        }
+
+        long long matches = query_file(path, query);
+        if (matches < 0) {
+            fclose(fp);
+            return -1;
+        }
+        if (query->count_only) {
+            printf("%s: %lld\n", path, matches);
+        }
+        total += matches;
+    }
+
+    fclose(fp);
+    return total;
+}
+
+// Resolve a --from/--to argument to microseconds
+static int parse_time_argument(const char *text, const char *first_log, long long *time_us) {
+    log_parser_t parser;
+    int relative;
+    int hour, minute, second = 0;
+    char tail;
+
+    log_parser_init(&parser);
+
+    // Time of day, combined with the date of the first record
+    if ((sscanf(text, "%d:%d:%d%c", &hour, &minute, &second, &tail) == 3 ||
+         sscanf(text, "%d:%d%c", &hour, &minute, &tail) == 2) &&
+        strchr(text, '-') == NULL) {
+        long long first_us;
+        char absolute[64];
+
+        if (!first_log || first_record_time(first_log, &first_us, &relative) < 0 || relative) {
+            fprintf(stderr, "Error: Cannot derive a date for %s from the first log\n", text);
+            return -1;
+        }
+
+        time_t first_s = (time_t)(first_us / 1000000);
+        struct tm tm_info;
+        localtime_r(&first_s, &tm_info);
+        snprintf(absolute, sizeof(absolute), "%04d-%02d-%02d %02d:%02d:%02d",
+                 tm_info.tm_year + 1900, tm_info.tm_mon + 1, tm_info.tm_mday,
+                 hour, minute, second);
+        return log_parse_time(&parser, absolute, strlen(absolute), time_us, &relative);
+    }
+
+    if (log_parse_time(&parser, text, strlen(text), time_us, &relative) < 0) {
+        fprintf(stderr, "Error: Invalid time %s\n", text);
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_signal_list(const char *text, unsigned int *mask) {
+    *mask = 0;
+    while (*text) {
+        size_t len = strcspn(text, ",");
+        signal_id_t signal = log_parse_signal(text, len);
+        if (signal == SIGNAL_COUNT) {
+            fprintf(stderr, "Error: Unknown signal %.*s (use CTS, RTS, DSR, DTR)\n", (int)len, text);
+            return -1;
+        }
+        *mask |= 1u << signal;
+        text += len;
+        if (*text == ',') {
+            text++;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    query_t query;
+    const char *from_text = NULL;
+    const char *to_text = NULL;
+    const char *files[argc];
+    int file_count = 0;
+
+    memset(&query, 0, sizeof(query));
+    query.signal_mask = (1u << SIGNAL_COUNT) - 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        else if (strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) {
+            if (i + 1 < argc) {
+                if (argv[i][2] == 'f') {
+                    from_text = argv[++i];
+                } else {
+                    to_text = argv[++i];
+                }
+            } else {
+                fprintf(stderr, "Error: %s option requires a time\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0) {
+            if (i + 1 < argc) {
+                if (parse_signal_list(argv[++i], &query.signal_mask) < 0) {
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: -s option requires a signal list\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--all") == 0) {
+            query.all_records = 1;
+        }
+        else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--count") == 0) {
+            query.count_only = 1;
+        }
+        else if (strcmp(argv[i], "--rebuild") == 0) {
+            query.rebuild = 1;
+        }
+        else if (argv[i][0] != '-') {
+            files[file_count++] = argv[i];
+        }
+        else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (file_count == 0 || !from_text || !to_text) {
+        fprintf(stderr, "Error: A time range and at least one log must be specified\n");
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Time-of-day arguments take their date from the first real log file
+    const char *first_log = files[0];
+    char first_segment[4096];
+    size_t first_len = strlen(first_log);
+    if (first_len > 4 && strcmp(first_log + first_len - 4, ".idx") == 0) {
+        snprintf(first_segment, sizeof(first_segment), "%.*s.0000", (int)(first_len - 4), first_log);
+        first_log = first_segment;
+    }
+
+    if (parse_time_argument(from_text, first_log, &query.from_us) < 0 ||
+        parse_time_argument(to_text, first_log, &query.to_us) < 0) {
+        return EXIT_FAILURE;
+    }
+    if (query.from_us > query.to_us) {
+        fprintf(stderr, "Error: --from must not be after --to\n");
+        return EXIT_FAILURE;
+    }
+
+    query.with_filename = file_count > 1;
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < file_count; i++) {
+        size_t len = strlen(files[i]);
+        long long matches;
+
+        if (len > 4 && strcmp(files[i] + len - 4, ".idx") == 0) {
+            matches = query_segment_index(files[i], &query);
+        } else {
+            matches = query_file(files[i], &query);
+            if (matches >= 0 && query.count_only) {
+                printf("%s: %lld\n", files[i], matches);
+            }
+        }
+        if (matches < 0) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    fflush(stdout);
+    return status;
+}
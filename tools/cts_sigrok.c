@@ -0,0 +1,520 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include "log_parse.h"
+
+// Samples buffered per logic chunk in the session archive
+#define CHUNK_SIZE (4 * 1024 * 1024)
+
+// Largest archive the plain (non-zip64) format can address
+#define ZIP_LIMIT 0xFFFFFFFFULL
+
+// Fixed part of a local file header and a central directory entry
+#define ZIP_LOCAL_HEADER 30
+#define ZIP_CENTRAL_HEADER 46
+#define ZIP_END_RECORD 22
+
+typedef struct {
+    char name[32];
+    uint32_t crc;
+    uint32_t size;
+    uint32_t offset;
+} zip_entry_t;
+
+// Streaming zip writer using the store method, one buffered entry at a time
+typedef struct {
+    FILE *fp;
+    uint64_t offset;
+    zip_entry_t *entries;
+    size_t count;
+    size_t capacity;
+    uint16_t dos_time;
+    uint16_t dos_date;
+} zip_writer_t;
+
+// Logic sample stream split into logic-1-N chunks
+typedef struct {
+    zip_writer_t zip;
+    unsigned char *chunk;
+    size_t fill;
+    unsigned int chunk_number;
+    uint64_t written;       // Samples emitted so far
+    unsigned char value;    // Current sample: bit n = n-th selected signal
+} sample_stream_t;
+
+static uint32_t crc_table[256];
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options] -o <session.sr> <log>...\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help     Show this help message\n");
+    printf("  -o FILE        Output sigrok session file\n");
+    printf("  -r RATE        Sample rate in Hz, k/M suffix allowed (default: 1M)\n");
+    printf("  -s SIGNALS     Comma-separated signals to export (default: CTS,RTS)\n");
+    printf("\n");
+    printf("Converts text logs (several files are read in order, e.g. rotated\n");
+    printf("segments) into a sigrok session with one logic channel per signal.\n");
+    printf("Memory use is bounded by one %d MB chunk; sessions are limited to 4 GB.\n",
+           CHUNK_SIZE / (1024 * 1024));
+}
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc32_compute(const unsigned char *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static unsigned char *put16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+
+static unsigned char *put32(unsigned char *p, uint32_t v) {
+    p = put16(p, (uint16_t)v);
+    return put16(p, (uint16_t)(v >> 16));
+}
+
+static int zip_open(zip_writer_t *zip, const char *path) {
+    memset(zip, 0, sizeof(*zip));
+    zip->fp = fopen(path, "wb");
+    if (!zip->fp) {
+        fprintf(stderr, "Error creating %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    time_t now = time(NULL);
+    struct tm *tm_info = localtime(&now);
+    zip->dos_time = (uint16_t)((tm_info->tm_hour << 11) | (tm_info->tm_min << 5) | (tm_info->tm_sec / 2));
+    zip->dos_date = (uint16_t)(((tm_info->tm_year - 80) << 9) | ((tm_info->tm_mon + 1) << 5) | tm_info->tm_mday);
+    return 0;
+}
+
+// Append one stored entry; the data is complete, so no data descriptor is needed
+static int zip_add(zip_writer_t *zip, const char *name, const void *data, size_t size) {
+    unsigned char header[ZIP_LOCAL_HEADER];
+    size_t name_len = strlen(name);
+
+    // Leave room for this entry's central directory record and the end record
+    uint64_t central = (zip->count + 1) * (ZIP_CENTRAL_HEADER + sizeof(zip->entries[0].name));
+    if (zip->offset + ZIP_LOCAL_HEADER + name_len + size + central + ZIP_END_RECORD > ZIP_LIMIT) {
+        fprintf(stderr, "Error: Session exceeds 4 GB; use a lower sample rate or a shorter log\n");
+        return -1;
+    }
+
+    if (zip->count == zip->capacity) {
+        size_t capacity = zip->capacity ? zip->capacity * 2 : 64;
+        zip_entry_t *entries = realloc(zip->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+        zip->entries = entries;
+        zip->capacity = capacity;
+    }
+
+    zip_entry_t *entry = &zip->entries[zip->count++];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    entry->crc = crc32_compute(data, size);
+    entry->size = (uint32_t)size;
+    entry->offset = (uint32_t)zip->offset;
+
+    unsigned char *p = put32(header, 0x04034b50);
+    p = put16(p, 20);               // Version needed to extract
+    p = put16(p, 0);                // Flags
+    p = put16(p, 0);                // Method: stored
+    p = put16(p, zip->dos_time);
+    p = put16(p, zip->dos_date);
+    p = put32(p, entry->crc);
+    p = put32(p, entry->size);      // Compressed size
+    p = put32(p, entry->size);      // Uncompressed size
+    p = put16(p, (uint16_t)name_len);
+    put16(p, 0);                    // Extra field length
+
+    if (fwrite(header, sizeof(header), 1, zip->fp) != 1 ||
+        fwrite(name, name_len, 1, zip->fp) != 1 ||
+        (size > 0 && fwrite(data, size, 1, zip->fp) != 1)) {
+        fprintf(stderr, "Error writing session: %s\n", strerror(errno));
+        return -1;
+    }
+    zip->offset += sizeof(header) + name_len + size;
+    return 0;
+}
+
+// Write the central directory and close the archive
+static int zip_close(zip_writer_t *zip) {
+    unsigned char record[ZIP_CENTRAL_HEADER];
+    uint64_t central_start = zip->offset;
+    int failed = 0;
+
+    for (size_t i = 0; i < zip->count; i++) {
+        const zip_entry_t *entry = &zip->entries[i];
+        size_t name_len = strlen(entry->name);
+
+        unsigned char *p = put32(record, 0x02014b50);
+        p = put16(p, 20);           // Version made by
+        p = put16(p, 20);           // Version needed to extract
+        p = put16(p, 0);            // Flags
+        p = put16(p, 0);            // Method: stored
+        p = put16(p, zip->dos_time);
+        p = put16(p, zip->dos_date);
+        p = put32(p, entry->crc);
+        p = put32(p, entry->size);
+        p = put32(p, entry->size);
+        p = put16(p, (uint16_t)name_len);
+        p = put16(p, 0);            // Extra field length
+        p = put16(p, 0);            // Comment length
+        p = put16(p, 0);            // Disk number
+        p = put16(p, 0);            // Internal attributes
+        p = put32(p, 0);            // External attributes
+        put32(p, entry->offset);
+
+        failed |= fwrite(record, sizeof(record), 1, zip->fp) != 1;
+        failed |= fwrite(entry->name, name_len, 1, zip->fp) != 1;
+        zip->offset += sizeof(record) + name_len;
+    }
+
+    unsigned char end[ZIP_END_RECORD];
+    unsigned char *p = put32(end, 0x06054b50);
+    p = put16(p, 0);                // Disk number
+    p = put16(p, 0);                // Disk with the central directory
+    p = put16(p, (uint16_t)zip->count);
+    p = put16(p, (uint16_t)zip->count);
+    p = put32(p, (uint32_t)(zip->offset - central_start));
+    p = put32(p, (uint32_t)central_start);
+    put16(p, 0);                    // Comment length
+    failed |= fwrite(end, sizeof(end), 1, zip->fp) != 1;
+
+    failed |= fclose(zip->fp) != 0;
+    free(zip->entries);
+    if (failed) {
+        fprintf(stderr, "Error writing session: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int flush_chunk(sample_stream_t *stream) {
+    char name[32];
+
+    if (stream->fill == 0) {
+        return 0;
+    }
+    snprintf(name, sizeof(name), "logic-1-%u", ++stream->chunk_number);
+    if (zip_add(&stream->zip, name, stream->chunk, stream->fill) < 0) {
+        return -1;
+    }
+    stream->fill = 0;
+    return 0;
+}
+
+// Repeat the current sample value count times
+static int emit_samples(sample_stream_t *stream, uint64_t count) {
+    while (count > 0) {
+        size_t n = CHUNK_SIZE - stream->fill;
+        if (n > count) {
+            n = (size_t)count;
+        }
+        memset(stream->chunk + stream->fill, stream->value, n);
+        stream->fill += n;
+        stream->written += n;
+        count -= n;
+        if (stream->fill == CHUNK_SIZE && flush_chunk(stream) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int parse_rate(const char *text, unsigned long long *rate) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+
+    if (end == text || value == 0) {
+        return -1;
+    }
+    if (*end == 'k' || *end == 'K') {
+        value *= 1000ULL;
+        end++;
+    } else if (*end == 'M') {
+        value *= 1000000ULL;
+        end++;
+    }
+    if (*end != '\0' && strcmp(end, "Hz") != 0) {
+        return -1;
+    }
+    *rate = value;
+    return 0;
+}
+
+static void format_rate(unsigned long long rate, char *buffer, size_t size) {
+    if (rate % 1000000ULL == 0) {
+        snprintf(buffer, size, "%llu MHz", rate / 1000000ULL);
+    } else if (rate % 1000ULL == 0) {
+        snprintf(buffer, size, "%llu kHz", rate / 1000ULL);
+    } else {
+        snprintf(buffer, size, "%llu Hz", rate);
+    }
+}
+
+static int parse_signal_list(const char *text, signal_id_t *channels, int *channel_count) {
+    *channel_count = 0;
+    while (*text) {
+        size_t len = strcspn(text, ",");
+        signal_id_t signal = log_parse_signal(text, len);
+        if (signal == SIGNAL_COUNT) {
+            fprintf(stderr, "Error: Unknown signal %.*s (use CTS, RTS, DSR, DTR)\n", (int)len, text);
+            return -1;
+        }
+        if (*channel_count == SIGNAL_COUNT) {
+            fprintf(stderr, "Error: Too many signals\n");
+            return -1;
+        }
+        channels[(*channel_count)++] = signal;
+        text += len;
+        if (*text == ',') {
+            text++;
+        }
+    }
+    return *channel_count > 0 ? 0 : -1;
+}
+
+// Derive each channel's starting level from its first edge (the level before it)
+static int initial_levels(const char *const *files, int file_count, const int channel_of[SIGNAL_COUNT],
+                          unsigned char *value) {
+    log_parser_t parser;
+    log_record_t record;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    int pending = 0;
+
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        if (channel_of[i] >= 0) {
+            pending |= 1 << i;
+        }
+    }
+
+    log_parser_init(&parser);
+    *value = 0;
+    for (int f = 0; f < file_count && pending; f++) {
+        FILE *fp = fopen(files[f], "r");
+        if (!fp) {
+            fprintf(stderr, "Error opening %s: %s\n", files[f], strerror(errno));
+            free(line);
+            return -1;
+        }
+        while (pending && (len = getline(&line, &line_size, fp)) > 0) {
+            if (log_parse_line(&parser, line, (size_t)len, &record) < 0 || !record.is_edge ||
+                !(pending & (1 << record.signal))) {
+                continue;
+            }
+            if (!record.state) {
+                *value |= 1u << channel_of[record.signal];
+            }
+            pending &= ~(1 << record.signal);
+        }
+        fclose(fp);
+    }
+
+    free(line);
+    return 0;
+}
+
+static int write_metadata(zip_writer_t *zip, unsigned long long rate,
+                          const signal_id_t *channels, int channel_count) {
+    static const char *const signal_names[SIGNAL_COUNT] = { "CTS", "RTS", "DSR", "DTR" };
+    char metadata[512];
+    char samplerate[32];
+
+    format_rate(rate, samplerate, sizeof(samplerate));
+    int len = snprintf(metadata, sizeof(metadata),
+                       "[global]\nsigrok version=0.5.2\n\n"
+                       "[device 1]\ncapturefile=logic-1\ntotal probes=%d\n"
+                       "samplerate=%s\ntotal analog=0\n",
+                       channel_count, samplerate);
+    for (int i = 0; i < channel_count; i++) {
+        len += snprintf(metadata + len, sizeof(metadata) - len, "probe%d=%s\n",
+                        i + 1, signal_names[channels[i]]);
+    }
+    len += snprintf(metadata + len, sizeof(metadata) - len, "unitsize=1\n");
+
+    if (zip_add(zip, "version", "2", 1) < 0 ||
+        zip_add(zip, "metadata", metadata, (size_t)len) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int convert(const char *const *files, int file_count, sample_stream_t *stream,
+                   unsigned long long rate, const int channel_of[SIGNAL_COUNT]) {
+    log_parser_t parser;
+    log_record_t record;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    long long start_us = 0;
+    int started = 0;
+    unsigned long long edges = 0;
+
+    log_parser_init(&parser);
+    for (int f = 0; f < file_count; f++) {
+        FILE *fp = fopen(files[f], "r");
+        if (!fp) {
+            fprintf(stderr, "Error opening %s: %s\n", files[f], strerror(errno));
+            free(line);
+            return -1;
+        }
+
+        while ((len = getline(&line, &line_size, fp)) > 0) {
+            if (log_parse_line(&parser, line, (size_t)len, &record) < 0) {
+                continue;
+            }
+            if (!started) {
+                start_us = record.time_us;
+                started = 1;
+            }
+            if (!record.is_edge || channel_of[record.signal] < 0) {
+                continue;
+            }
+
+            // Sample index of the edge; edges within one sample collapse
+            unsigned long long delta = record.time_us > start_us ? (unsigned long long)(record.time_us - start_us) : 0;
+            uint64_t index = (delta / 1000000ULL) * rate + (delta % 1000000ULL) * rate / 1000000ULL;
+            if (index > stream->written && emit_samples(stream, index - stream->written) < 0) {
+                fclose(fp);
+                free(line);
+                return -1;
+            }
+
+            unsigned char bit = (unsigned char)(1u << channel_of[record.signal]);
+            stream->value = record.state ? (stream->value | bit) : (stream->value & ~bit);
+            edges++;
+        }
+        fclose(fp);
+    }
+    free(line);
+
+    // One trailing sample so the last edge is visible
+    if (emit_samples(stream, 1) < 0 || flush_chunk(stream) < 0) {
+        return -1;
+    }
+
+    printf("Exported %llu edges as %llu samples in %u chunks\n",
+           edges, (unsigned long long)stream->written, stream->chunk_number);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *output_file = NULL;
+    const char *files[argc];
+    int file_count = 0;
+    unsigned long long rate = 1000000ULL;
+    signal_id_t channels[SIGNAL_COUNT] = { SIGNAL_CTS, SIGNAL_RTS };
+    int channel_count = 2;
+    int channel_of[SIGNAL_COUNT];
+    sample_stream_t stream;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        else if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 < argc) {
+                output_file = argv[++i];
+            } else {
+                fprintf(stderr, "Error: -o option requires an output file\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-r") == 0) {
+            if (i + 1 < argc) {
+                if (parse_rate(argv[++i], &rate) < 0) {
+                    fprintf(stderr, "Error: Invalid sample rate %s\n", argv[i]);
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: -r option requires a sample rate\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0) {
+            if (i + 1 < argc) {
+                if (parse_signal_list(argv[++i], channels, &channel_count) < 0) {
+                    return EXIT_FAILURE;
+                }
+            } else {
+                fprintf(stderr, "Error: -s option requires a signal list\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i][0] != '-') {
+            files[file_count++] = argv[i];
+        }
+        else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (file_count == 0 || output_file == NULL) {
+        fprintf(stderr, "Error: An output file and at least one log file must be specified\n");
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < SIGNAL_COUNT; i++) {
+        channel_of[i] = -1;
+    }
+    for (int i = 0; i < channel_count; i++) {
+        channel_of[channels[i]] = i;
+    }
+
+    crc_init();
+    memset(&stream, 0, sizeof(stream));
+    if (initial_levels(files, file_count, channel_of, &stream.value) < 0) {
+        return EXIT_FAILURE;
+    }
+
+    stream.chunk = malloc(CHUNK_SIZE);
+    if (!stream.chunk) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    if (zip_open(&stream.zip, output_file) < 0) {
+        free(stream.chunk);
+        return EXIT_FAILURE;
+    }
+
+    int result = write_metadata(&stream.zip, rate, channels, channel_count);
+    if (result == 0) {
+        result = convert(files, file_count, &stream, rate, channel_of);
+    }
+    if (zip_close(&stream.zip) < 0) {
+        result = -1;
+    }
+    free(stream.chunk);
+
+    if (result < 0) {
+        remove(output_file);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}